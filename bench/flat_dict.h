@@ -0,0 +1,592 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef FLAT_DICT_H
+#define FLAT_DICT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NPNR_FLAT_DICT_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "hashlib.h"
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace flat_dict_detail {
+
+// Control byte of a slot: empty, deleted, or the low 7 bits of the hash of a full slot
+typedef int8_t ctrl_t;
+const ctrl_t ctrl_empty = -128;
+const ctrl_t ctrl_deleted = -2;
+
+inline int lowest_bit(uint64_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+#ifdef NPNR_FLAT_DICT_SSE2
+// A group of control bytes, compared in parallel. Match masks have bit i set for each matching slot i.
+struct Group
+{
+    static const int width = 16;
+    __m128i ctrl;
+    explicit Group(const ctrl_t *pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+    uint64_t match(ctrl_t h2) const { return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))); }
+    uint64_t match_empty() const { return match(ctrl_empty); }
+    // Empty and deleted are the only control bytes with the top bit set
+    uint64_t match_empty_or_deleted() const { return uint32_t(_mm_movemask_epi8(ctrl)); }
+    static int next(uint64_t &mask)
+    {
+        int i = lowest_bit(mask);
+        mask &= mask - 1;
+        return i;
+    }
+};
+#else
+// Portable fallback, comparing eight control bytes packed into a word. Match masks have the top bit of byte i set for
+// each matching slot i; match() can rarely give false positives, which the key comparison rejects.
+struct Group
+{
+    static const int width = 8;
+    static const uint64_t lsbs = 0x0101010101010101ULL;
+    static const uint64_t msbs = 0x8080808080808080ULL;
+    uint64_t ctrl = 0;
+    explicit Group(const ctrl_t *pos)
+    {
+        for (int i = 0; i < width; i++)
+            ctrl |= uint64_t(uint8_t(pos[i])) << (8 * i);
+    }
+    uint64_t match(ctrl_t h2) const
+    {
+        uint64_t x = ctrl ^ (lsbs * uint8_t(h2));
+        return (x - lsbs) & ~x & msbs;
+    }
+    uint64_t match_empty() const { return (ctrl & ~(ctrl << 6)) & msbs; }
+    uint64_t match_empty_or_deleted() const { return ctrl & msbs; }
+    static int next(uint64_t &mask)
+    {
+        int i = lowest_bit(mask) >> 3;
+        mask &= mask - 1;
+        return i;
+    }
+};
+#endif
+
+// hash_ops hashes are often weak in the low bits (e.g. small integer indices), so mix them before splitting
+inline uint32_t mix_hash(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+} // namespace flat_dict_detail
+
+// A drop-in alternative to dict, measured against it by hashlib_bench.cc. Entries are kept in a dense vector exactly as
+// in dict, so iteration order is identical; only the index differs. Instead of a prime-sized bucket array with chained
+// next links, the index is an open addressing table of entry indices with one control byte per slot, probed a group of
+// control bytes at a time (Swiss table style).
+template <typename K, typename T, typename OPS = hash_ops<K>> class flat_dict
+{
+    typedef flat_dict_detail::ctrl_t ctrl_t;
+    typedef flat_dict_detail::Group Group;
+
+    struct entry_t
+    {
+        std::pair<K, T> udata;
+
+        entry_t() {}
+        entry_t(const std::pair<K, T> &udata) : udata(udata) {}
+        entry_t(std::pair<K, T> &&udata) : udata(std::move(udata)) {}
+    };
+
+    // The index, as a power of two number of groups. The control bytes of a group are stored next to its entry
+    // indices, so a probe reads one small block of memory before the entry itself
+    struct group_t
+    {
+        ctrl_t ctrl[Group::width];
+        int index[Group::width];
+    };
+
+    std::vector<entry_t> entries;
+    std::vector<group_t> groups;
+    // Inserts possible into empty slots before the index must be rebuilt, keeping the load at most 7/8
+    int growth_left = 0;
+    OPS ops;
+
+    uint32_t do_hash(const K &key) const { return flat_dict_detail::mix_hash(ops.hash(key)); }
+    static ctrl_t h2(uint32_t hash) { return ctrl_t(hash & 0x7F); }
+
+    // Slots are numbered group * Group::width + lane
+    ctrl_t &slot_ctrl(int slot) { return groups[slot / Group::width].ctrl[slot % Group::width]; }
+    int &slot_index(int slot) { return groups[slot / Group::width].index[slot % Group::width]; }
+
+    // Slot holding key, or -1
+    int find_slot(const K &key, uint32_t hash) const
+    {
+        if (groups.empty())
+            return -1;
+        int gmask = int(groups.size()) - 1;
+        int g = int(hash >> 7) & gmask;
+        for (int step = 1;; step++) {
+            const group_t &grp = groups[g];
+            Group group(grp.ctrl);
+            uint64_t match = group.match(h2(hash));
+            while (match) {
+                int lane = Group::next(match);
+                if (ops.cmp(entries[grp.index[lane]].udata.first, key))
+                    return g * Group::width + lane;
+            }
+            if (group.match_empty())
+                return -1;
+            // Triangular probing visits every group of a power of two sized table
+            g = (g + step) & gmask;
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence for hash
+    int find_free_slot(uint32_t hash) const
+    {
+        int gmask = int(groups.size()) - 1;
+        int g = int(hash >> 7) & gmask;
+        for (int step = 1;; step++) {
+            uint64_t match = Group(groups[g].ctrl).match_empty_or_deleted();
+            if (match)
+                return g * Group::width + Group::next(match);
+            g = (g + step) & gmask;
+        }
+    }
+
+    void set_slot(int slot, uint32_t hash, int index)
+    {
+        if (slot_ctrl(slot) == flat_dict_detail::ctrl_empty)
+            --growth_left;
+        slot_ctrl(slot) = h2(hash);
+        slot_index(slot) = index;
+    }
+
+    // Rebuild the index from the entries, big enough for min_size entries
+    void do_rehash(size_t min_size)
+    {
+        size_t capacity = Group::width;
+        while (capacity * 7 / 8 < min_size)
+            capacity *= 2;
+        group_t empty_group;
+        std::fill(empty_group.ctrl, empty_group.ctrl + Group::width, flat_dict_detail::ctrl_empty);
+        std::fill(empty_group.index, empty_group.index + Group::width, -1);
+        groups.assign(capacity / Group::width, empty_group);
+        growth_left = int(capacity * 7 / 8);
+        for (int i = 0; i < int(entries.size()); i++) {
+            uint32_t hash = do_hash(entries[i].udata.first);
+            set_slot(find_free_slot(hash), hash, i);
+        }
+    }
+
+    void do_rehash() { do_rehash(std::max(entries.size(), entries.capacity())); }
+
+    // Entry index of key, or -1. This is find_slot, but returning the entry index directly as it is the hot path
+    int do_lookup(const K &key, uint32_t hash) const
+    {
+        if (groups.empty())
+            return -1;
+        int gmask = int(groups.size()) - 1;
+        int g = int(hash >> 7) & gmask;
+        for (int step = 1;; step++) {
+            const group_t &grp = groups[g];
+            Group group(grp.ctrl);
+            uint64_t match = group.match(h2(hash));
+            while (match) {
+                int index = grp.index[Group::next(match)];
+                if (ops.cmp(entries[index].udata.first, key))
+                    return index;
+            }
+            if (group.match_empty())
+                return -1;
+            g = (g + step) & gmask;
+        }
+    }
+
+    // Add a new entry, whose key must not already be present
+    int do_insert(std::pair<K, T> &&value, uint32_t hash)
+    {
+        entries.emplace_back(std::move(value));
+        int index = int(entries.size()) - 1;
+        if (growth_left == 0) {
+            // Either grow, or just clear out deleted slots if there are plenty of them; this includes the new entry
+            do_rehash(std::max(entries.size(), entries.capacity()));
+        } else {
+            set_slot(find_free_slot(hash), hash, index);
+        }
+        return index;
+    }
+
+    int do_erase(int index)
+    {
+        if (index < 0)
+            return 0;
+        uint32_t hash = do_hash(entries[index].udata.first);
+        int slot = find_slot(entries[index].udata.first, hash);
+        NPNR_ASSERT(slot >= 0 && slot_index(slot) == index);
+        // A probe reaching a group with an empty slot stops there, so the slot can only become empty again if its
+        // group already has one; otherwise it must be marked deleted to keep later keys on the probe sequence reachable
+        if (Group(groups[slot / Group::width].ctrl).match_empty()) {
+            slot_ctrl(slot) = flat_dict_detail::ctrl_empty;
+            ++growth_left;
+        } else {
+            slot_ctrl(slot) = flat_dict_detail::ctrl_deleted;
+        }
+        slot_index(slot) = -1;
+
+        // Fill the hole with the last entry, as dict does
+        int back_idx = int(entries.size()) - 1;
+        if (index != back_idx) {
+            int back_slot = find_slot(entries[back_idx].udata.first, do_hash(entries[back_idx].udata.first));
+            NPNR_ASSERT(back_slot >= 0 && slot_index(back_slot) == back_idx);
+            slot_index(back_slot) = index;
+            entries[index] = std::move(entries[back_idx]);
+        }
+        entries.pop_back();
+
+        if (entries.empty())
+            clear();
+        return 1;
+    }
+
+  public:
+    using key_type = K;
+    using mapped_type = T;
+    using value_type = std::pair<K, T>;
+
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
+    {
+        friend class flat_dict;
+
+      protected:
+        const flat_dict *ptr;
+        int index;
+        const_iterator(const flat_dict *ptr, int index) : ptr(ptr), index(index) {}
+
+      public:
+        const_iterator() {}
+        const_iterator operator++()
+        {
+            index--;
+            return *this;
+        }
+        const_iterator operator+=(int amt)
+        {
+            index -= amt;
+            return *this;
+        }
+        bool operator<(const const_iterator &other) const { return index > other.index; }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+        const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+        const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+    };
+
+    class iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
+    {
+        friend class flat_dict;
+
+      protected:
+        flat_dict *ptr;
+        int index;
+        iterator(flat_dict *ptr, int index) : ptr(ptr), index(index) {}
+
+      public:
+        iterator() {}
+        iterator operator++()
+        {
+            index--;
+            return *this;
+        }
+        iterator operator+=(int amt)
+        {
+            index -= amt;
+            return *this;
+        }
+        bool operator<(const iterator &other) const { return index > other.index; }
+        bool operator==(const iterator &other) const { return index == other.index; }
+        bool operator!=(const iterator &other) const { return index != other.index; }
+        std::pair<K, T> &operator*() { return ptr->entries[index].udata; }
+        std::pair<K, T> *operator->() { return &ptr->entries[index].udata; }
+        const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+        const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+        operator const_iterator() const { return const_iterator(ptr, index); }
+    };
+
+    flat_dict() {}
+
+    flat_dict(const flat_dict &other)
+    {
+        entries = other.entries;
+        do_rehash();
+    }
+
+    flat_dict(flat_dict &&other) { swap(other); }
+
+    flat_dict &operator=(const flat_dict &other)
+    {
+        entries = other.entries;
+        do_rehash();
+        return *this;
+    }
+
+    flat_dict &operator=(flat_dict &&other)
+    {
+        clear();
+        swap(other);
+        return *this;
+    }
+
+    flat_dict(const std::initializer_list<std::pair<K, T>> &list)
+    {
+        for (auto &it : list)
+            insert(it);
+    }
+
+    template <class InputIterator> flat_dict(InputIterator first, InputIterator last) { insert(first, last); }
+
+    template <class InputIterator> void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    std::pair<iterator, bool> insert(const K &key)
+    {
+        uint32_t hash = do_hash(key);
+        int i = do_lookup(key, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::pair<K, T>(key, T()), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> insert(const std::pair<K, T> &value)
+    {
+        uint32_t hash = do_hash(value.first);
+        int i = do_lookup(value.first, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::pair<K, T>(value), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> insert(std::pair<K, T> &&rvalue)
+    {
+        uint32_t hash = do_hash(rvalue.first);
+        int i = do_lookup(rvalue.first, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::forward<std::pair<K, T>>(rvalue), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> emplace(K const &key, T const &value)
+    {
+        uint32_t hash = do_hash(key);
+        int i = do_lookup(key, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::make_pair(key, value), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> emplace(K const &key, T &&rvalue)
+    {
+        uint32_t hash = do_hash(key);
+        int i = do_lookup(key, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::make_pair(key, std::forward<T>(rvalue)), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> emplace(K &&rkey, T const &value)
+    {
+        uint32_t hash = do_hash(rkey);
+        int i = do_lookup(rkey, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::make_pair(std::forward<K>(rkey), value), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> emplace(K &&rkey, T &&rvalue)
+    {
+        uint32_t hash = do_hash(rkey);
+        int i = do_lookup(rkey, hash);
+        if (i >= 0)
+            return std::pair<iterator, bool>(iterator(this, i), false);
+        i = do_insert(std::make_pair(std::forward<K>(rkey), std::forward<T>(rvalue)), hash);
+        return std::pair<iterator, bool>(iterator(this, i), true);
+    }
+
+    int erase(const K &key) { return do_erase(do_lookup(key, do_hash(key))); }
+
+    iterator erase(iterator it)
+    {
+        do_erase(it.index);
+        return ++it;
+    }
+
+    int count(const K &key) const { return do_lookup(key, do_hash(key)) < 0 ? 0 : 1; }
+
+    int count(const K &key, const_iterator it) const
+    {
+        int i = do_lookup(key, do_hash(key));
+        return i < 0 || i > it.index ? 0 : 1;
+    }
+
+    iterator find(const K &key)
+    {
+        int i = do_lookup(key, do_hash(key));
+        if (i < 0)
+            return end();
+        return iterator(this, i);
+    }
+
+    const_iterator find(const K &key) const
+    {
+        int i = do_lookup(key, do_hash(key));
+        if (i < 0)
+            return end();
+        return const_iterator(this, i);
+    }
+
+    T &at(const K &key)
+    {
+        int i = do_lookup(key, do_hash(key));
+        if (i < 0)
+            throw std::out_of_range("flat_dict::at()");
+        return entries[i].udata.second;
+    }
+
+    const T &at(const K &key) const
+    {
+        int i = do_lookup(key, do_hash(key));
+        if (i < 0)
+            throw std::out_of_range("flat_dict::at()");
+        return entries[i].udata.second;
+    }
+
+    const T &at(const K &key, const T &defval) const
+    {
+        int i = do_lookup(key, do_hash(key));
+        if (i < 0)
+            return defval;
+        return entries[i].udata.second;
+    }
+
+    T &operator[](const K &key)
+    {
+        uint32_t hash = do_hash(key);
+        int i = do_lookup(key, hash);
+        if (i < 0)
+            i = do_insert(std::pair<K, T>(key, T()), hash);
+        return entries[i].udata.second;
+    }
+
+    template <typename Compare = std::less<K>> void sort(Compare comp = Compare())
+    {
+        std::sort(entries.begin(), entries.end(),
+                  [comp](const entry_t &a, const entry_t &b) { return comp(b.udata.first, a.udata.first); });
+        do_rehash();
+    }
+
+    void swap(flat_dict &other)
+    {
+        entries.swap(other.entries);
+        groups.swap(other.groups);
+        std::swap(growth_left, other.growth_left);
+    }
+
+    bool operator==(const flat_dict &other) const
+    {
+        if (size() != other.size())
+            return false;
+        for (auto &it : entries) {
+            auto oit = other.find(it.udata.first);
+            if (oit == other.end() || !(oit->second == it.udata.second))
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const flat_dict &other) const { return !operator==(other); }
+
+    unsigned int hash() const
+    {
+        unsigned int h = mkhash_init;
+        for (auto &entry : entries) {
+            h ^= hash_ops<K>::hash(entry.udata.first);
+            h ^= hash_ops<T>::hash(entry.udata.second);
+        }
+        return h;
+    }
+
+    void reserve(size_t n)
+    {
+        entries.reserve(n);
+        if (n > size_t(growth_left) + entries.size())
+            do_rehash(n);
+    }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear()
+    {
+        entries.clear();
+        groups.clear();
+        growth_left = 0;
+    }
+
+    iterator begin() { return iterator(this, int(entries.size()) - 1); }
+    iterator element(int n) { return iterator(this, int(entries.size()) - 1 - n); }
+    iterator end() { return iterator(nullptr, -1); }
+
+    const_iterator begin() const { return const_iterator(this, int(entries.size()) - 1); }
+    const_iterator element(int n) const { return const_iterator(this, int(entries.size()) - 1 - n); }
+    const_iterator end() const { return const_iterator(nullptr, -1); }
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* FLAT_DICT_H */
@@ -0,0 +1,215 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Micro-benchmark comparing dict and flat_dict, keyed by IdString and WireId, over the operations the router
+// performs on wire maps. Run with no arguments; each figure is the mean time of one operation in ns, the best of several
+// runs.
+//
+// The "many" rows spread the same number of keys over maps of 16 entries each, which is closer to the per-net wire
+// maps (NetInfo::wires) than one large table, as most nets only use a handful of wires.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "archdefs.h"
+#include "flat_dict.h"
+#include "hashlib.h"
+#include "idstring.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+
+// Roughly the shape of the values stored in the wire maps (a PipMap is a pip and a strength)
+typedef std::pair<int32_t, int32_t> Value;
+
+// Enough operations per measurement that small tables are timed over many repeats
+const size_t target_ops = 1 << 22;
+
+volatile uint64_t sink;
+
+template <typename F> double time_ns_per_op(size_t ops, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / double(ops);
+}
+
+struct Keys
+{
+    // Distinct key indices, in a random order, and the same number of indices that are not in the table
+    std::vector<int32_t> present, absent;
+};
+
+Keys make_keys(size_t count, std::mt19937 &rng)
+{
+    std::vector<int32_t> all(count * 2);
+    std::iota(all.begin(), all.end(), 1);
+    std::shuffle(all.begin(), all.end(), rng);
+    Keys keys;
+    keys.present.assign(all.begin(), all.begin() + count);
+    keys.absent.assign(all.begin() + count, all.end());
+    return keys;
+}
+
+struct Result
+{
+    double insert, hit, miss, churn, iterate;
+};
+
+// Run each operation over `maps` tables of `size` entries each
+template <typename Map, typename K> Result run_maps(size_t maps, size_t size, std::mt19937 &rng)
+{
+    size_t total = maps * size;
+    std::vector<std::vector<K>> present(maps), absent(maps);
+    for (size_t m = 0; m < maps; m++) {
+        Keys keys = make_keys(size, rng);
+        for (int32_t i : keys.present)
+            present.at(m).push_back(K(i));
+        for (int32_t i : keys.absent)
+            absent.at(m).push_back(K(i));
+    }
+    size_t repeats = std::max<size_t>(1, target_ops / total);
+    size_t ops = repeats * total;
+    Result r;
+    std::vector<Map> tables(maps);
+
+    r.insert = time_ns_per_op(ops, [&]() {
+        for (size_t i = 0; i < repeats; i++) {
+            for (size_t m = 0; m < maps; m++) {
+                Map &t = tables.at(m);
+                t.clear();
+                for (auto &k : present.at(m))
+                    t.emplace(k, Value(1, 2));
+            }
+        }
+    });
+
+    // Lookups visit the tables in turn, like a router walking many nets, rather than hammering one table
+    r.hit = time_ns_per_op(ops, [&]() {
+        uint64_t found = 0;
+        for (size_t i = 0; i < repeats; i++)
+            for (size_t j = 0; j < size; j++)
+                for (size_t m = 0; m < maps; m++)
+                    found += tables.at(m).count(present.at(m).at(j));
+        sink = found;
+    });
+
+    r.miss = time_ns_per_op(ops, [&]() {
+        uint64_t found = 0;
+        for (size_t i = 0; i < repeats; i++)
+            for (size_t j = 0; j < size; j++)
+                for (size_t m = 0; m < maps; m++)
+                    found += tables.at(m).count(absent.at(m).at(j));
+        sink = found;
+    });
+
+    // Rip up and reroute: erase a key and insert another, keeping the size constant
+    r.churn = time_ns_per_op(ops, [&]() {
+        for (size_t i = 0; i < repeats; i++) {
+            for (size_t m = 0; m < maps; m++) {
+                Map &t = tables.at(m);
+                auto &from = (i % 2) ? absent.at(m) : present.at(m);
+                auto &to = (i % 2) ? present.at(m) : absent.at(m);
+                for (size_t j = 0; j < size; j++) {
+                    t.erase(from.at(j));
+                    t.emplace(to.at(j), Value(3, 4));
+                }
+            }
+        }
+    });
+
+    // The running value depends on the order of the entries, as a plain sum over the small tables is vectorised by -O3
+    // for one container's entry layout and not the other, which measures the vectoriser rather than the iteration
+    r.iterate = time_ns_per_op(ops, [&]() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < repeats; i++)
+            for (auto &t : tables)
+                for (auto &entry : t)
+                    sum = sum * 31 + uint64_t(entry.second.first);
+        sink = sum;
+    });
+    return r;
+}
+
+// Lowest of each figure over several runs, as the noise in a timing only ever makes it slower
+Result best_of(const Result &a, const Result &b)
+{
+    return Result{std::min(a.insert, b.insert), std::min(a.hit, b.hit), std::min(a.miss, b.miss),
+                  std::min(a.churn, b.churn), std::min(a.iterate, b.iterate)};
+}
+
+template <typename K> void compare(const char *key_name, size_t maps, size_t size, std::mt19937 &rng)
+{
+    // Both containers see the same keys in every run. An untimed warm-up run of each comes first, so neither is
+    // measured while the allocator and caches are still cold, and the one that runs first alternates between runs.
+    const int runs = 4;
+    std::mt19937 run_rng = rng;
+    run_maps<dict<K, Value>, K>(maps, size, run_rng);
+    run_rng = rng;
+    run_maps<flat_dict<K, Value>, K>(maps, size, run_rng);
+    Result chained, flat;
+    for (int i = 0; i < runs; i++) {
+        Result rc, rf;
+        std::mt19937 rng_chained = rng, rng_flat = rng;
+        if (i % 2) {
+            rf = run_maps<flat_dict<K, Value>, K>(maps, size, rng_flat);
+            rc = run_maps<dict<K, Value>, K>(maps, size, rng_chained);
+        } else {
+            rc = run_maps<dict<K, Value>, K>(maps, size, rng_chained);
+            rf = run_maps<flat_dict<K, Value>, K>(maps, size, rng_flat);
+        }
+        chained = i ? best_of(chained, rc) : rc;
+        flat = i ? best_of(flat, rf) : rf;
+    }
+    rng = run_rng;
+    auto row = [&](const char *container, const Result &r) {
+        printf("%-9s %-10s %8zu %8zu %8.1f %8.1f %8.1f %8.1f %8.1f\n", key_name, container, maps, size, r.insert,
+               r.hit, r.miss, r.churn, r.iterate);
+    };
+    row("dict", chained);
+    row("flat_dict", flat);
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(1);
+    printf("%-9s %-10s %8s %8s %8s %8s %8s %8s %8s\n", "key", "container", "maps", "size", "insert", "hit", "miss",
+           "churn", "iterate");
+    // One table of each size, then the same number of keys spread over many small tables
+    const size_t sizes[] = {16, 256, 4096, 65536, 1 << 20};
+    for (size_t size : sizes) {
+        compare<IdString>("IdString", 1, size, rng);
+        compare<WireId>("WireId", 1, size, rng);
+    }
+    const size_t many_keys[] = {65536, 1 << 20};
+    for (size_t keys : many_keys) {
+        compare<IdString>("IdString", keys / 16, 16, rng);
+        compare<WireId>("WireId", keys / 16, 16, rng);
+    }
+    return 0;
+}
@@ -127,6 +127,13 @@ fn_wrapper_0a<Context, decltype(&Context::archId), &Context::archId, conv_to_str
 fn_wrapper_2a_v<Context, decltype(&Context::writeSVG), &Context::writeSVG, pass_through<std::string>,
                 pass_through<std::string>>::def_wrap(ctx_cls, "writeSVG");
 
+fn_wrapper_1a_v<Context, decltype(&Context::writeSnapshot), &Context::writeSnapshot,
+                pass_through<std::string>>::def_wrap(ctx_cls, "writeSnapshot");
+fn_wrapper_1a_v<Context, decltype(&Context::loadSnapshot), &Context::loadSnapshot,
+                pass_through<std::string>>::def_wrap(ctx_cls, "loadSnapshot");
+fn_wrapper_0a_v<Context, decltype(&Context::checkpoint), &Context::checkpoint>::def_wrap(ctx_cls, "checkpoint");
+fn_wrapper_0a_v<Context, decltype(&Context::rollback), &Context::rollback>::def_wrap(ctx_cls, "rollback");
+
 fn_wrapper_2a<Context, decltype(&Context::isBelLocationValid), &Context::isBelLocationValid, pass_through<bool>,
               conv_from_str<BelId>, pass_through<bool>>::def_wrap(ctx_cls, "isBelLocationValid");
 
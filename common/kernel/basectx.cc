@@ -19,10 +19,12 @@
 
 #include "basectx.h"
 
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 
 #include "context.h"
 #include "log.h"
+#include "util.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -312,4 +314,20 @@ void BaseCtx::copyBelPorts(IdString cell, BelId bel)
     }
 }
 
+ThreadPool *BaseCtx::getThreadPool(int min_threads) const
+{
+    int threads = std::max(min_threads, int_or_default(settings, id("threads"), 1));
+    if (threads <= 1)
+        return nullptr;
+    // Callers hold on to the pool for the length of their pass, and may call this from one of its workers, so a pool
+    // is never replaced once started. ThreadPool::run() hands out indices dynamically, so a pass still works on a
+    // pool smaller than it asked for
+#ifndef NPNR_DISABLE_THREADS
+    std::lock_guard<std::mutex> lock(thread_pool_mutex);
+#endif
+    if (!thread_pool)
+        thread_pool.reset(new ThreadPool(threads));
+    return thread_pool.get();
+}
+
 NEXTPNR_NAMESPACE_END
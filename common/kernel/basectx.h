@@ -30,10 +30,12 @@
 
 #include "hashlib.h"
 #include "idstring.h"
+#include "idstring_db.h"
 #include "nextpnr_namespaces.h"
 #include "nextpnr_types.h"
 #include "property.h"
 #include "str_ring_buffer.h"
+#include "thread_pool.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -53,8 +55,7 @@ struct BaseCtx
 #endif
 
     // ID String database.
-    mutable std::unordered_map<std::string, int> *idstring_str_to_idx;
-    mutable std::vector<const std::string *> *idstring_idx_to_str;
+    mutable IdStringDb *idstring_db;
 
     // Temporary string backing store for logging
     mutable StrRingBuffer log_strs;
@@ -87,6 +88,13 @@ struct BaseCtx
     // Fmax data post timing analysis
     TimingResult timing_result;
 
+    // Worker threads shared by the passes of this Context, see getThreadPool(). Started lazily, also from const
+    // methods such as writeSDF, as doing so doesn't change the design
+    mutable std::unique_ptr<ThreadPool> thread_pool;
+#ifndef NPNR_DISABLE_THREADS
+    mutable std::mutex thread_pool_mutex;
+#endif
+
     Context *as_ctx = nullptr;
 
     // Has the frontend loaded a design?
@@ -94,19 +102,14 @@ struct BaseCtx
 
     BaseCtx()
     {
-        idstring_str_to_idx = new std::unordered_map<std::string, int>;
-        idstring_idx_to_str = new std::vector<const std::string *>;
+        idstring_db = new IdStringDb;
         IdString::initialize_add(this, "", 0);
         IdString::initialize_arch(this);
 
         design_loaded = false;
     }
 
-    virtual ~BaseCtx()
-    {
-        delete idstring_str_to_idx;
-        delete idstring_idx_to_str;
-    }
+    virtual ~BaseCtx() { delete idstring_db; }
 
     // Must be called before performing any mutating changes on the Ctx/Arch.
     void lock(void)
@@ -242,6 +245,14 @@ struct BaseCtx
 
     void archInfoToAttributes();
     void attributesToArchInfo();
+
+    // provided by basectx.cc
+    // Worker threads for passes that split work up, sized by the "threads" setting and only started on first use, so
+    // passes share one set of threads instead of each starting their own. A pass with its own default thread count
+    // can pass it as min_threads to get at least that many when "threads" isn't set. nullptr if that comes to only one
+    // thread. The pool is sized by the first call that wants one and never replaced, so a later call asking for more
+    // threads gets the existing pool; the pointer stays valid for the life of the Context. Safe to call from workers
+    ThreadPool *getThreadPool(int min_threads = 1) const;
 };
 
 NEXTPNR_NAMESPACE_END
@@ -53,4 +53,20 @@ int Bits::generic_ctz(unsigned int x)
     log_error("Unreachable!");
 }
 
+int Bits::generic_clz(unsigned int x)
+{
+    if (x == 0) {
+        log_error("Cannot call clz with arg = 0");
+    }
+
+    for (size_t i = 0; i < std::numeric_limits<unsigned int>::digits; ++i) {
+        if ((x & (1u << (std::numeric_limits<unsigned int>::digits - 1 - i))) != 0) {
+            return i;
+        }
+    }
+
+    // Unreachable!
+    log_error("Unreachable!");
+}
+
 NEXTPNR_NAMESPACE_END
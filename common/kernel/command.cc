@@ -33,14 +33,19 @@
 #include <boost/program_options.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <random>
 #include <set>
+#include <thread>
 
 #include "command.h"
 #include "design_utils.h"
 #include "json_frontend.h"
 #include "jsonwrite.h"
 #include "log.h"
+#include "profiler.h"
+#include "thread_pool.h"
 #include "timing.h"
 #include "util.h"
 #include "version.h"
@@ -302,6 +307,14 @@ bool CommandHandler::executeBeforeContext()
             log_error("Failed to open log file '%s' for writing.\n", logfilename.c_str());
         log_streams.push_back(std::make_pair(&logfile, LogLevel::LOG_MSG));
     }
+
+    conflicting_options(vm, "json", "load-snapshot");
+    if (vm.count("seed-sweep")) {
+        if (vm["seed-sweep"].as<int>() < 1)
+            log_error("Seed sweep needs at least one seed.\n");
+        for (const char *opt : {"pack-only", "no-place", "no-route", "randomize-seed", "pre-route", "run", "gui"})
+            conflicting_options(vm, "seed-sweep", opt);
+    }
     return false;
 }
 
@@ -318,6 +331,12 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("debug-placer", "debug output from placer only");
     general.add_options()("debug-router", "debug output from router only");
     general.add_options()("threads", po::value<int>(), "number of threads for passes where this is configurable");
+#if !defined(NPNR_DISABLE_THREADS)
+    general.add_options()("async-log", "write log output from a background thread; output not yet written when "
+                                       "nextpnr crashes is lost");
+#endif
+    general.add_options()("profile-trace", po::value<std::string>(),
+                          "record the time spent in each phase and write it to a Chrome trace JSON file");
 
     general.add_options()("force,f", "keep running after errors");
 #ifndef NO_GUI
@@ -338,9 +357,17 @@ po::options_description CommandHandler::getGeneralOptions()
 #endif
     general.add_options()("json", po::value<std::string>(), "JSON design file to ingest");
     general.add_options()("write", po::value<std::string>(), "JSON design file to write");
+    general.add_options()("load-snapshot", po::value<std::string>(),
+                          "binary design snapshot to load instead of a JSON design (use --no-pack etc. as needed)");
+    general.add_options()("write-snapshot", po::value<std::string>(),
+                          "binary design snapshot to write, for quickly reloading a packed or placed design");
     general.add_options()("top", po::value<std::string>(), "name of top module");
     general.add_options()("seed", po::value<int>(), "seed value for random number generator");
     general.add_options()("randomize-seed,r", "randomize seed value for random number generator");
+    general.add_options()("seed-sweep", po::value<int>(),
+                          "place and route the packed design with N consecutive seeds, starting from --seed, in "
+                          "parallel (up to --threads, or one per CPU, at a time) and keep the result with the best "
+                          "Fmax. --pre-place scripts run once, before the design is copied for each seed");
 
     general.add_options()(
             "placer", po::value<std::string>(),
@@ -364,6 +391,9 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("no-pack", "process design without packing");
 
     general.add_options()("ignore-loops", "ignore combinational loops in timing analysis");
+    general.add_options()("timing-corners", po::value<std::string>(),
+                          "additional timing corners to analyse, as a comma separated list of "
+                          "name:logic_derate[:routing_derate]");
     general.add_options()("ignore-rel-clk", "ignore clock-to-clock relations in timing checks");
 
     general.add_options()("version,V", "show version");
@@ -401,6 +431,12 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("report", po::value<std::string>(),
                           "write timing and utilization report in JSON format to file");
     general.add_options()("detailed-timing-report", "Append detailed net timing data to the JSON report");
+    general.add_options()("timing-db", po::value<std::string>(),
+                          "write a binary timing database to file, for offline query with python/timing_db.py");
+    general.add_options()("report-paths", po::value<int>(),
+                          "number of worst paths to report for each clock pair (default: 1)");
+    general.add_options()("report-paths-per-endpoint", po::value<int>(),
+                          "maximum number of reported paths ending at the same endpoint (default: unlimited)");
 
     general.add_options()("placed-svg", po::value<std::string>(), "write render of placement to SVG file");
     general.add_options()("routed-svg", po::value<std::string>(), "write render of routing to SVG file");
@@ -470,6 +506,10 @@ void CommandHandler::setupContext(Context *ctx)
         ctx->settings[ctx->id("timing/ignoreLoops")] = true;
     }
 
+    if (vm.count("timing-corners")) {
+        ctx->settings[ctx->id("timing/corners")] = vm["timing-corners"].as<std::string>();
+    }
+
     if (vm.count("ignore-rel-clk")) {
         ctx->settings[ctx->id("timing/ignoreRelClk")] = true;
     }
@@ -569,6 +609,16 @@ void CommandHandler::setupContext(Context *ctx)
     if (vm.count("detailed-timing-report")) {
         ctx->detailed_timing_report = true;
     }
+    if (vm.count("report-paths")) {
+        ctx->report_paths = vm["report-paths"].as<int>();
+        if (ctx->report_paths < 1)
+            log_error("Number of paths to report must be at least 1\n");
+    }
+    if (vm.count("report-paths-per-endpoint")) {
+        ctx->report_paths_per_endpoint = vm["report-paths-per-endpoint"].as<int>();
+        if (ctx->report_paths_per_endpoint < 0)
+            log_error("Number of paths per endpoint to report must not be negative\n");
+    }
 }
 
 int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
@@ -588,6 +638,8 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 
 #ifndef NO_GUI
     if (vm.count("gui")) {
+        // The GUI sets up its own log sinks, which must be called from the GUI thread
+        log_async_stop();
         Application a(argc, argv, (vm.count("gui-no-aa") > 0));
         MainWindow w(std::move(ctx), this);
         try {
@@ -612,10 +664,20 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
     if (vm.count("json")) {
         std::string filename = vm["json"].as<std::string>();
         std::ifstream f(filename);
-        if (!parse_json(f, filename, ctx.get()))
-            log_error("Loading design failed.\n");
+        {
+            NPNR_PROFILE_ZONE("load_json");
+            if (!parse_json(f, filename, ctx.get()))
+                log_error("Loading design failed.\n");
+        }
 
         customAfterLoad(ctx.get());
+    } else if (vm.count("load-snapshot")) {
+        {
+            NPNR_PROFILE_ZONE("load_snapshot");
+            ctx->loadSnapshot(vm["load-snapshot"].as<std::string>());
+        }
+        // Options given on the command line take precedence over the settings saved in the snapshot
+        setupContext(ctx.get());
     }
 
 #ifndef NO_PYTHON
@@ -636,53 +698,79 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 
         if (do_pack) {
             run_script_hook("pre-pack");
+            NPNR_PROFILE_ZONE("pack");
             if (!ctx->pack() && !ctx->force)
                 log_error("Packing design failed.\n");
         }
         ctx->check();
+        ctx->compactNetUsers();
         print_utilisation(ctx.get());
 
-        if (do_place) {
+        bool seed_sweep = vm.count("seed-sweep") != 0;
+        if (seed_sweep)
+            runSeedSweep(ctx.get());
+
+        if (do_place && !seed_sweep) {
             run_script_hook("pre-place");
             bool saved_debug = ctx->debug;
             if (vm.count("debug-placer"))
                 ctx->debug = true;
-            if (!ctx->place() && !ctx->force)
-                log_error("Placing design failed.\n");
+            {
+                NPNR_PROFILE_ZONE("place");
+                if (!ctx->place() && !ctx->force)
+                    log_error("Placing design failed.\n");
+            }
             ctx->debug = saved_debug;
             ctx->check();
+            ctx->compactNetUsers();
             if (vm.count("placed-svg"))
                 ctx->writeSVG(vm["placed-svg"].as<std::string>(), "scale=50 hide_routing");
         }
 
-        if (do_route) {
+        if (do_route && !seed_sweep) {
             run_script_hook("pre-route");
             bool saved_debug = ctx->debug;
             if (vm.count("debug-router"))
                 ctx->debug = true;
-            if (!ctx->route() && !ctx->force)
-                log_error("Routing design failed.\n");
+            {
+                NPNR_PROFILE_ZONE("route");
+                if (!ctx->route() && !ctx->force)
+                    log_error("Routing design failed.\n");
+            }
             ctx->debug = saved_debug;
+        }
+
+        if (do_route) {
             run_script_hook("post-route");
             if (vm.count("routed-svg"))
                 ctx->writeSVG(vm["routed-svg"].as<std::string>(), "scale=500");
         }
 
-        customBitstream(ctx.get());
+        {
+            NPNR_PROFILE_ZONE("bitstream");
+            customBitstream(ctx.get());
+        }
     }
 
     if (vm.count("write")) {
         std::string filename = vm["write"].as<std::string>();
         std::ofstream f(filename);
+        NPNR_PROFILE_ZONE("write_json");
         if (!write_json_file(f, filename, ctx.get()))
             log_error("Saving design failed.\n");
     }
 
+    if (vm.count("write-snapshot")) {
+        NPNR_PROFILE_ZONE("write_snapshot");
+        ctx->writeSnapshot(vm["write-snapshot"].as<std::string>());
+    }
+
     if (vm.count("sdf")) {
         std::string filename = vm["sdf"].as<std::string>();
         std::ofstream f(filename);
         if (!f)
             log_error("Failed to open SDF file '%s' for writing.\n", filename.c_str());
+        NPNR_PROFILE_ZONE("write_sdf");
         ctx->writeSDF(f, vm.count("sdf-cvc"));
     }
 
@@ -691,9 +779,19 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         std::ofstream f(filename);
         if (!f)
             log_error("Failed to open report file '%s' for writing.\n", filename.c_str());
+        NPNR_PROFILE_ZONE("write_report");
         ctx->writeJsonReport(f);
     }
 
+    if (vm.count("timing-db")) {
+        std::string filename = vm["timing-db"].as<std::string>();
+        std::ofstream f(filename, std::ios::binary);
+        if (!f)
+            log_error("Failed to open timing database file '%s' for writing.\n", filename.c_str());
+        NPNR_PROFILE_ZONE("write_timing_db");
+        ctx->writeTimingDatabase(f);
+    }
+
 #ifndef NO_PYTHON
     deinit_python();
 #endif
@@ -701,6 +799,185 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
     return had_nonfatal_error ? 1 : 0;
 }
 
+// Place and route a copy of the packed design for each seed of the sweep, in parallel, and keep the best result in ctx.
+// Every copy is a Context of its own, so they share nothing mutable; arches with a chip database map it only once. The
+// seeds are handed out to the threads one at a time, so only as many copies as run at once are alive at any time, with
+// the best result so far kept as a snapshot. The log output of each copy is held back, and only that of the chosen seed
+// is written out, with every line tagged with the seed.
+void CommandHandler::runSeedSweep(Context *ctx)
+{
+    NPNR_PROFILE_ZONE("seed_sweep");
+    int count = vm["seed-sweep"].as<int>();
+    int base_seed = vm.count("seed") ? vm["seed"].as<int>() : 1;
+    int threads = vm.count("threads") ? vm["threads"].as<int>() : int(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(count, threads));
+    bool debug_placer = vm.count("debug-placer") != 0, debug_router = vm.count("debug-router") != 0;
+    // Only one thread may use Python at once, so the script runs here, once, and the copies get any changes it makes
+    // to the design through the snapshot
+    run_script_hook("pre-place");
+    std::vector<uint8_t> packed = ctx->saveSnapshot();
+
+    struct SeedResult
+    {
+        bool ok = false;
+        // Worst achieved/target Fmax ratio over all clocks, and the clock it is for
+        float fmax_ratio = std::numeric_limits<float>::infinity();
+        std::string worst_clock;
+        ClockFmax worst_fmax{0, 0};
+        size_t wires = 0;
+        // The error a failed seed stopped with, without its "ERROR: " prefix and newline
+        std::string error;
+    };
+    std::vector<SeedResult> results(count);
+    // Best Fmax relative to the target first, then least wire usage, then the lowest seed, so the choice doesn't
+    // depend on the order the seeds finish in
+    auto better = [&](int i, int j) {
+        const auto &a = results.at(i), &b = results.at(j);
+        if (a.fmax_ratio != b.fmax_ratio)
+            return a.fmax_ratio > b.fmax_ratio;
+        if (a.wires != b.wires)
+            return a.wires < b.wires;
+        return i < j;
+    };
+    int best = -1;
+    std::vector<uint8_t> best_snapshot;
+    LogCapture best_log;
+    std::mutex setup_mutex, best_mutex;
+    bool saved_nonfatal_error = had_nonfatal_error;
+    auto saved_message_counts = message_count_by_level;
+
+    log_info("Placing and routing %d seeds, %d at a time...\n", count, threads);
+    ThreadPool pool(threads);
+    pool.run(count, [&](int i) {
+        int seed = base_seed + i;
+        auto &result = results.at(i);
+        LogCapture seed_log;
+        std::unique_ptr<Context> run_ctx;
+        {
+            ScopedLogCapture capture(seed_log);
+            try {
+                {
+                    // Loading the chip database isn't thread safe, and setting up a copy is quick next to placing it
+                    std::lock_guard<std::mutex> lock(setup_mutex);
+                    log_info("Setting up a copy of the design for seed %d...\n", seed);
+                    dict<std::string, Property> values;
+                    run_ctx = createContext(values);
+                    setupContext(run_ctx.get());
+                    setupArchContext(run_ctx.get());
+                    run_ctx->restoreSnapshot(packed.data(), packed.size());
+                }
+                // The copies are already run in parallel, so passes within each one must stay on a single thread
+                run_ctx->settings[run_ctx->id("threads")] = 1;
+                run_ctx->rngseed(seed);
+                run_ctx->settings[run_ctx->id("seed")] = run_ctx->rngstate;
+                bool saved_debug = run_ctx->debug;
+                run_ctx->debug = saved_debug || debug_placer;
+                {
+                    NPNR_PROFILE_ZONE("place");
+                    if (!run_ctx->place() && !run_ctx->force)
+                        log_error("Placing design failed for seed %d.\n", seed);
+                }
+                run_ctx->check();
+                run_ctx->compactNetUsers();
+                run_ctx->debug = saved_debug || debug_router;
+                {
+                    NPNR_PROFILE_ZONE("route");
+                    if (!run_ctx->route() && !run_ctx->force)
+                        log_error("Routing design failed for seed %d.\n", seed);
+                }
+                run_ctx->debug = saved_debug;
+                result.ok = true;
+            } catch (log_execution_error_exception) {
+                // Only this seed is given up on
+                for (auto &msg : seed_log.messages) {
+                    if (msg.first != LogLevel::ERROR_MSG)
+                        continue;
+                    result.error = msg.second;
+                    if (boost::starts_with(result.error, "ERROR: "))
+                        result.error.erase(0, 7);
+                    boost::trim_right(result.error);
+                }
+            }
+            if (!result.ok)
+                return;
+            // Not every router leaves timing results behind, so analyse the routed design here
+            TimingAnalyser tmg(run_ctx.get());
+            tmg.setup(false /* update_net_timings */, false /* update_histogram */, true /* update_crit_paths */);
+            for (auto &clock : tmg.get_timing_result().clock_fmax) {
+                float ratio = clock.second.achieved / clock.second.constraint;
+                if (ratio < result.fmax_ratio) {
+                    result.fmax_ratio = ratio;
+                    result.worst_clock = clock.first.str(run_ctx.get());
+                    result.worst_fmax = clock.second;
+                }
+            }
+            for (auto &net : run_ctx->nets)
+                result.wires += net.second->wires.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(best_mutex);
+            if (best != -1 && !better(i, best))
+                return;
+        }
+        // Snapshot outside the lock, then check again, as another seed may have done better in the meantime
+        std::vector<uint8_t> snapshot = run_ctx->saveSnapshot();
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if (best == -1 || better(i, best)) {
+            best = i;
+            best_snapshot = std::move(snapshot);
+            best_log = std::move(seed_log);
+        }
+    });
+    // Errors and warnings of the seeds not chosen don't count; those of the chosen one are counted as it is replayed
+    had_nonfatal_error = saved_nonfatal_error;
+    message_count_by_level = saved_message_counts;
+
+    log_break();
+    log_info("Seed sweep results:\n");
+    for (int i = 0; i < count; i++) {
+        const auto &result = results.at(i);
+        if (!result.ok && result.error.empty())
+            log_info("    seed %d: failed\n", base_seed + i);
+        else if (!result.ok)
+            log_info("    seed %d: failed: %s\n", base_seed + i, result.error.c_str());
+        else if (result.worst_clock.empty())
+            log_info("    seed %d: %zu wires\n", base_seed + i, result.wires);
+        else
+            log_info("    seed %d: %.02f MHz for clock '%s' (target %.02f MHz), %zu wires\n", base_seed + i,
+                     result.worst_fmax.achieved, result.worst_clock.c_str(), result.worst_fmax.constraint,
+                     result.wires);
+    }
+    if (best == -1)
+        log_error("Placement and routing failed for every seed of the sweep.\n");
+    log_info("Keeping the result of seed %d.\n", base_seed + best);
+    log_break();
+    log_replay(best_log, stringf("[seed %d] ", base_seed + best));
+    for (auto &msg : best_log.messages) {
+        // Plain log output is never counted, only that logged through log_with_level
+        if (msg.first == LogLevel::LOG_MSG || msg.first == LogLevel::ALWAYS_MSG)
+            continue;
+        message_count_by_level[msg.first]++;
+        // With --Werror, warnings were logged as non-fatal errors
+        if (msg.first == LogLevel::ERROR_MSG)
+            had_nonfatal_error = true;
+    }
+    log_break();
+
+    ctx->restoreSnapshot(best_snapshot.data(), best_snapshot.size());
+    // The copy ran single threaded, but later passes on the result should use the threads asked for
+    if (vm.count("threads"))
+        ctx->settings[ctx->id("threads")] = vm["threads"].as<int>();
+    else
+        ctx->settings.erase(ctx->id("threads"));
+    ctx->check();
+    if (vm.count("placed-svg"))
+        ctx->writeSVG(vm["placed-svg"].as<std::string>(), "scale=50 hide_routing");
+    log_info("Checksum: 0x%08x\n", ctx->checksum());
+    timing_analysis(ctx, true /* slack_histogram */, true /* print_fmax */, true /* print_path */,
+                    true /* warn_on_failure */, true /* update_results */);
+}
+
 void CommandHandler::conflicting_options(const boost::program_options::variables_map &vm, const char *opt1,
                                          const char *opt2)
 {
@@ -719,6 +996,21 @@ void CommandHandler::printFooter()
                    error_count == 1 ? "" : "s");
 }
 
+void CommandHandler::writeProfileTrace()
+{
+    if (!vm.count("profile-trace") || !profile_enabled())
+        return;
+    profile_stop();
+    std::string filename = vm["profile-trace"].as<std::string>();
+    std::ofstream f(filename);
+    if (!f) {
+        log_nonfatal_error("Failed to open profile trace file '%s' for writing.\n", filename.c_str());
+        return;
+    }
+    profile_write_trace(f);
+    log_info("Wrote profile trace to '%s'.\n", filename.c_str());
+}
+
 int CommandHandler::exec()
 {
     try {
@@ -728,16 +1020,24 @@ int CommandHandler::exec()
         if (executeBeforeContext())
             return 0;
 
+        // The log streams are set up by now, so they can be written from a background thread for the rest of the flow.
+        // Only on request, as anything still buffered is lost if nextpnr crashes
+        ScopedAsyncLog async_log(vm.count("async-log") != 0);
+        if (vm.count("profile-trace"))
+            profile_start();
+
         dict<std::string, Property> values;
         std::unique_ptr<Context> ctx = createContext(values);
         setupContext(ctx.get());
         setupArchContext(ctx.get());
         int rc = executeMain(std::move(ctx));
+        writeProfileTrace();
         printFooter();
         log_break();
         log_info("Program finished normally.\n");
         return rc;
     } catch (log_execution_error_exception) {
+        writeProfileTrace();
         printFooter();
         return -1;
     }
@@ -55,8 +55,10 @@ class CommandHandler
     bool executeBeforeContext();
     void setupContext(Context *ctx);
     int executeMain(std::unique_ptr<Context> ctx);
+    void runSeedSweep(Context *ctx);
     po::options_description getGeneralOptions();
     void printFooter();
+    void writeProfileTrace();
 
   protected:
     po::variables_map vm;
@@ -97,7 +97,14 @@ WireId Context::getNetinfoSinkWire(const NetInfo *net_info, const PortRef &sink,
 
 delay_t Context::predictArcDelay(const NetInfo *net_info, const PortRef &sink) const
 {
-    if (net_info->driver.cell == nullptr || net_info->driver.cell->bel == BelId() || sink.cell->bel == BelId())
+    if (net_info->driver.cell == nullptr)
+        return 0;
+    return predictArcDelay(net_info, sink, net_info->driver.cell->bel, sink.cell->bel);
+}
+
+delay_t Context::predictArcDelay(const NetInfo *net_info, const PortRef &sink, BelId driver_bel, BelId sink_bel) const
+{
+    if (net_info->driver.cell == nullptr || driver_bel == BelId() || sink_bel == BelId())
         return 0;
     IdString driver_pin, sink_pin;
     // Pick the first pin for a prediction; assume all will be similar enouhg
@@ -111,7 +118,7 @@ delay_t Context::predictArcDelay(const NetInfo *net_info, const PortRef &sink) c
     }
     if (driver_pin == IdString() || sink_pin == IdString())
         return 0;
-    return predictDelay(net_info->driver.cell->bel, driver_pin, sink.cell->bel, sink_pin);
+    return predictDelay(driver_bel, driver_pin, sink_bel, sink_pin);
 }
 
 delay_t Context::getNetinfoRouteDelay(const NetInfo *net_info, const PortRef &user_info) const
@@ -223,6 +230,19 @@ static uint32_t xorshift32(uint32_t x)
     return x;
 }
 
+// Hashes the characters of string values, and the [01xz] characters of numeric values LSB first
+static uint32_t property_checksum(uint32_t x, const Property &prop)
+{
+    if (prop.is_string) {
+        for (char ch : prop.str)
+            x = xorshift32(x + xorshift32((int)ch));
+    } else {
+        for (int i = 0; i < int(prop.size()); i++)
+            x = xorshift32(x + xorshift32((int)prop.bit(i)));
+    }
+    return x;
+}
+
 uint32_t Context::checksum() const
 {
     uint32_t cksum = xorshift32(123456789);
@@ -247,8 +267,7 @@ uint32_t Context::checksum() const
         for (auto &a : ni.attrs) {
             uint32_t attr_x = 123456789;
             attr_x = xorshift32(attr_x + xorshift32(a.first.index));
-            for (char ch : a.second.str)
-                attr_x = xorshift32(attr_x + xorshift32((int)ch));
+            attr_x = property_checksum(attr_x, a.second);
             attr_x_sum += attr_x;
         }
         x = xorshift32(x + xorshift32(attr_x_sum));
@@ -291,8 +310,7 @@ uint32_t Context::checksum() const
         for (auto &a : ci.attrs) {
             uint32_t attr_x = 123456789;
             attr_x = xorshift32(attr_x + xorshift32(a.first.index));
-            for (char ch : a.second.str)
-                attr_x = xorshift32(attr_x + xorshift32((int)ch));
+            attr_x = property_checksum(attr_x, a.second);
             attr_x_sum += attr_x;
         }
         x = xorshift32(x + xorshift32(attr_x_sum));
@@ -301,8 +319,7 @@ uint32_t Context::checksum() const
         for (auto &p : ci.params) {
             uint32_t param_x = 123456789;
             param_x = xorshift32(param_x + xorshift32(p.first.index));
-            for (char ch : p.second.str)
-                param_x = xorshift32(param_x + xorshift32((int)ch));
+            param_x = property_checksum(param_x, p.second);
             param_x_sum += param_x;
         }
         x = xorshift32(x + xorshift32(param_x_sum));
@@ -486,4 +503,22 @@ struct FixupHierarchyWorker
 
 void Context::fixupHierarchy() { FixupHierarchyWorker(this).run(); }
 
+void Context::compactNetUsers()
+{
+    int moved_nets = 0;
+    for (auto &net : nets) {
+        NetInfo *ni = net.second.get();
+        bool moved = ni->users.compact([&](store_index<PortRef> old_idx, store_index<PortRef> new_idx) {
+            PortRef &usr = ni->users.at(new_idx);
+            PortInfo &port = usr.cell->ports.at(usr.port);
+            NPNR_ASSERT(port.user_idx == old_idx);
+            port.user_idx = new_idx;
+        });
+        if (moved)
+            ++moved_nets;
+    }
+    if (moved_nets > 0 && debug)
+        log_info("Compacted the users of %d nets.\n", moved_nets);
+}
+
 NEXTPNR_NAMESPACE_END
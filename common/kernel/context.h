@@ -38,6 +38,10 @@ struct Context : Arch, DeterministicRNG
     bool disable_critical_path_source_print = false;
     // True when detailed per-net timing is to be stored / reported
     bool detailed_timing_report = false;
+    // Number of worst paths to report for each clock pair, and how many of those may end at the same endpoint (0 for
+    // any number)
+    int report_paths = 1;
+    int report_paths_per_endpoint = 0;
 
     ArchArgs arch_args;
 
@@ -52,6 +56,8 @@ struct Context : Arch, DeterministicRNG
     // --------------------------------------------------------------
 
     delay_t predictArcDelay(const NetInfo *net_info, const PortRef &sink) const;
+    // As above, but as if the driver and sink cells were placed at the given bels
+    delay_t predictArcDelay(const NetInfo *net_info, const PortRef &sink, BelId driver_bel, BelId sink_bel) const;
 
     WireId getNetinfoSourceWire(const NetInfo *net_info) const;
     SSOArray<WireId, 2> getNetinfoSinkWires(const NetInfo *net_info, const PortRef &sink) const;
@@ -87,6 +93,10 @@ struct Context : Arch, DeterministicRNG
     // call after changing hierpath or adding/removing nets and cells
     void fixupHierarchy();
 
+    // Fill the holes left in NetInfo::users by removed users, updating PortInfo::user_idx to match. Run between flow
+    // stages, as any store_index<PortRef> held elsewhere is invalidated
+    void compactNetUsers();
+
     // --------------------------------------------------------------
 
     // provided by sdf.cc
@@ -102,6 +112,22 @@ struct Context : Arch, DeterministicRNG
     // provided by report.cc
     void writeJsonReport(std::ostream &out) const;
 
+    // provided by timing_db.cc
+    void writeTimingDatabase(std::ostream &out);
+
+    // provided by snapshot.cc
+    // A binary copy of the design: the netlist, placement, routing, settings, attributes, hierarchy, regions and RNG
+    // state. Arch-specific cell and net data is rebuilt on restore with assignArchInfo(), as when loading JSON.
+    std::vector<uint8_t> saveSnapshot() const;
+    void restoreSnapshot(const uint8_t *data, size_t size);
+    void writeSnapshot(const std::string &filename) const;
+    void loadSnapshot(const std::string &filename);
+    // For trying things out in-process: rollback() returns to the design as it was at the last checkpoint(). Restoring
+    // recreates every cell and net, so any pointers to them are invalidated
+    void checkpoint();
+    void rollback();
+    std::vector<uint8_t> checkpoint_data;
+
     // provided by timing_log.cc
     void log_timing_results(TimingResult &result, bool print_histogram, bool print_fmax, bool print_path,
                             bool warn_on_failure);
@@ -21,31 +21,112 @@
 #include "idstring.h"
 
 #include "basectx.h"
+#include "hashlib.h"
+#include "idstring_db.h"
+#include "nextpnr_assertions.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
-void IdString::set(const BaseCtx *ctx, const std::string &s)
+IdStringDb::IdStringDb()
 {
-    auto it = ctx->idstring_str_to_idx->find(s);
-    if (it == ctx->idstring_str_to_idx->end()) {
-        index = ctx->idstring_idx_to_str->size();
-        auto insert_rc = ctx->idstring_str_to_idx->insert({s, index});
-        ctx->idstring_idx_to_str->push_back(&insert_rc.first->first);
-    } else {
-        index = it->second;
+    for (auto &chunk : chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+    for (auto &shard : shards)
+        shard.slots.resize(64, 0);
+}
+
+IdStringDb::~IdStringDb()
+{
+    for (auto &chunk : chunks)
+        delete[] chunk.load();
+}
+
+uint64_t *IdStringDb::find_slot(Shard &shard, const std::string &s, uint32_t hash)
+{
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = (hash >> shard_bits) & mask;; i = (i + 1) & mask) {
+        uint64_t &slot = shard.slots[i];
+        if (slot == 0)
+            return &slot;
+        if (uint32_t(slot >> 32) == hash && str(int(slot & 0xFFFFFFFF) - 1) == s)
+            return &slot;
+    }
+}
+
+void IdStringDb::grow(Shard &shard)
+{
+    // The slots keep the full hash, so strings don't need re-hashing
+    std::vector<uint64_t> old_slots(shard.slots.size() * 2, 0);
+    std::swap(old_slots, shard.slots);
+    size_t mask = shard.slots.size() - 1;
+    for (uint64_t slot : old_slots) {
+        if (slot == 0)
+            continue;
+        size_t i = (uint32_t(slot >> 32) >> shard_bits) & mask;
+        while (shard.slots[i] != 0)
+            i = (i + 1) & mask;
+        shard.slots[i] = slot;
+    }
+}
+
+void IdStringDb::store(int idx, const std::string &s)
+{
+    int chunk_idx = idx >> chunk_bits;
+    NPNR_ASSERT(chunk_idx < max_chunks);
+    std::string *chunk = chunks[chunk_idx].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        chunk = chunks[chunk_idx].load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            chunk = new std::string[chunk_size];
+            chunks[chunk_idx].store(chunk, std::memory_order_release);
+        }
+    }
+    chunk[idx & (chunk_size - 1)] = s;
+}
+
+int IdStringDb::get(const std::string &s)
+{
+    uint32_t hash = hash_ops<std::string>::hash(s);
+    Shard &shard = shards[hash & (num_shards - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint64_t *slot = find_slot(shard, s, hash);
+    if (*slot != 0)
+        return int(*slot & 0xFFFFFFFF) - 1;
+    int idx = next_index.fetch_add(1);
+    store(idx, s);
+    if (2 * (shard.used + 1) > int(shard.slots.size())) {
+        grow(shard);
+        slot = find_slot(shard, s, hash);
     }
+    *slot = (uint64_t(hash) << 32) | uint64_t(idx + 1);
+    ++shard.used;
+    return idx;
 }
 
-const std::string &IdString::str(const BaseCtx *ctx) const { return *ctx->idstring_idx_to_str->at(index); }
+bool IdStringDb::contains(const std::string &s)
+{
+    uint32_t hash = hash_ops<std::string>::hash(s);
+    Shard &shard = shards[hash & (num_shards - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return *find_slot(shard, s, hash) != 0;
+}
+
+void IdString::set(const BaseCtx *ctx, const std::string &s) { index = ctx->idstring_db->get(s); }
+
+const std::string &IdString::str(const BaseCtx *ctx) const
+{
+    NPNR_ASSERT(index >= 0 && index < ctx->idstring_db->size());
+    return ctx->idstring_db->str(index);
+}
 
 const char *IdString::c_str(const BaseCtx *ctx) const { return str(ctx).c_str(); }
 
 void IdString::initialize_add(const BaseCtx *ctx, const char *s, int idx)
 {
-    NPNR_ASSERT(ctx->idstring_str_to_idx->count(s) == 0);
-    NPNR_ASSERT(int(ctx->idstring_idx_to_str->size()) == idx);
-    auto insert_rc = ctx->idstring_str_to_idx->insert({s, idx});
-    ctx->idstring_idx_to_str->push_back(&insert_rc.first->first);
+    NPNR_ASSERT(!ctx->idstring_db->contains(s));
+    NPNR_ASSERT(ctx->idstring_db->size() == idx);
+    ctx->idstring_db->get(s);
 }
 
 NEXTPNR_NAMESPACE_END
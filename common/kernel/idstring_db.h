@@ -0,0 +1,86 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef IDSTRING_DB_H
+#define IDSTRING_DB_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// The interned strings behind IdString. Strings are stored by index in an arena of fixed-size chunks that never move,
+// so looking up the string of an index needs no locking. The string to index map is split into shards, each a small
+// open addressing table with its own lock, so IdStrings can be created from worker threads. Indices are handed out in
+// creation order, so a single-threaded flow gets the same IdStrings as it always has.
+struct IdStringDb
+{
+    IdStringDb();
+    ~IdStringDb();
+
+    IdStringDb(const IdStringDb &) = delete;
+    IdStringDb &operator=(const IdStringDb &) = delete;
+
+    // Get the index of a string, adding it if not yet present
+    int get(const std::string &s);
+    bool contains(const std::string &s);
+
+    // Only valid for indices returned by get()
+    const std::string &str(int idx) const
+    {
+        return chunks[idx >> chunk_bits].load(std::memory_order_acquire)[idx & (chunk_size - 1)];
+    }
+
+    // The number of indices handed out so far
+    int size() const { return next_index.load(); }
+
+  private:
+    static const int chunk_bits = 12;
+    static const int chunk_size = 1 << chunk_bits;
+    static const int max_chunks = 1 << 16;
+    static const int shard_bits = 6;
+    static const int num_shards = 1 << shard_bits;
+
+    std::atomic<std::string *> chunks[max_chunks];
+    std::mutex chunk_mutex;
+    std::atomic<int> next_index{0};
+
+    struct Shard
+    {
+        std::mutex mutex;
+        // (hash << 32) | (index + 1) per slot, zero for empty slots
+        std::vector<uint64_t> slots;
+        int used = 0;
+    };
+    Shard shards[num_shards];
+
+    // Returns the slot holding s, or the empty slot where it should be inserted
+    uint64_t *find_slot(Shard &shard, const std::string &s, uint32_t hash);
+    void grow(Shard &shard);
+    void store(int idx, const std::string &s);
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* IDSTRING_DB_H */
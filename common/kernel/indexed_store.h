@@ -25,6 +25,7 @@
 #include <type_traits>
 #include <vector>
 
+#include "bits.h"
 #include "nextpnr_assertions.h"
 #include "nextpnr_namespaces.h"
 
@@ -111,6 +112,31 @@ template <typename T> class indexed_store
     std::vector<slot> slots;
     int32_t first_free = 0;
     int32_t active_count = 0;
+    // One bit per slot, set for active slots, so iteration can skip over runs of free slots a word at a time
+    std::vector<uint32_t> active_mask;
+
+    void set_active_bit(int32_t idx)
+    {
+        if ((idx >> 5) >= int32_t(active_mask.size()))
+            active_mask.resize((idx >> 5) + 1, 0);
+        active_mask[idx >> 5] |= (1U << (idx & 31));
+    }
+    void clear_active_bit(int32_t idx) { active_mask[idx >> 5] &= ~(1U << (idx & 31)); }
+
+    // First active slot at or after idx, or the number of slots if there is none
+    int32_t next_active(int32_t idx) const
+    {
+        int32_t word = idx >> 5;
+        if (word >= int32_t(active_mask.size()))
+            return int32_t(slots.size());
+        uint32_t bits = active_mask[word] & (~0U << (idx & 31));
+        while (bits == 0) {
+            if (++word >= int32_t(active_mask.size()))
+                return int32_t(slots.size());
+            bits = active_mask[word];
+        }
+        return (word << 5) + Bits::ctz(bits);
+    }
 
   public:
     // Create a new entry and return its index
@@ -121,12 +147,14 @@ template <typename T> class indexed_store
             slots.emplace_back();
             slots.back().create(std::forward<Args &&>(args)...);
             ++first_free;
+            set_active_bit(int32_t(slots.size()) - 1);
             return store_index<T>(int32_t(slots.size()) - 1);
         } else {
             int32_t idx = first_free;
             auto &slot = slots.at(idx);
             first_free = slot.next_free;
             slot.create(std::forward<Args &&>(args)...);
+            set_active_bit(idx);
             return store_index<T>(idx);
         }
     }
@@ -136,14 +164,41 @@ template <typename T> class indexed_store
     {
         --active_count;
         slots.at(idx.m_index).free(first_free);
+        clear_active_bit(idx.m_index);
         first_free = idx.m_index;
     }
 
+    // Move all entries down to fill the free slots, keeping their order, and release the free slots. remap(old_idx,
+    // new_idx) is called for every entry that moves, so that anything holding its index can be updated. Returns true if
+    // any entry moved.
+    template <typename Func> bool compact(Func remap)
+    {
+        if (active_count == int32_t(slots.size()))
+            return false;
+        int32_t dst = 0;
+        for (int32_t src = next_active(0); src < int32_t(slots.size()); src = next_active(src + 1), ++dst) {
+            if (src == dst)
+                continue;
+            slots.at(dst).create(std::move(slots.at(src).obj()));
+            slots.at(src).free(0);
+            remap(store_index<T>(src), store_index<T>(dst));
+        }
+        NPNR_ASSERT(dst == active_count);
+        slots.resize(dst);
+        slots.shrink_to_fit();
+        first_free = dst;
+        active_mask.assign((dst + 31) / 32, ~0U);
+        if (dst % 32 != 0)
+            active_mask.back() = (1U << (dst % 32)) - 1;
+        return true;
+    }
+
     void clear()
     {
         active_count = 0;
         first_free = 0;
         slots.clear();
+        active_mask.clear();
     }
 
     // Number of live entries
@@ -186,17 +241,13 @@ template <typename T> class indexed_store
         inline iterator operator++()
         {
             // skip over unused slots
-            do {
-                index++;
-            } while (index < int32_t(base->slots.size()) && !base->slots.at(index).active);
+            index = base->next_active(index + 1);
             return *this;
         }
         inline iterator operator++(int)
         {
             iterator prior(*this);
-            do {
-                index++;
-            } while (index < int32_t(base->slots.size()) && !base->slots.at(index).active);
+            index = base->next_active(index + 1);
             return prior;
         }
         T &operator*() { return base->at(store_index<T>(index)); }
@@ -223,17 +274,13 @@ template <typename T> class indexed_store
         inline const_iterator operator++()
         {
             // skip over unused slots
-            do {
-                index++;
-            } while (index < int32_t(base->slots.size()) && !base->slots.at(index).active);
+            index = base->next_active(index + 1);
             return *this;
         }
         inline const_iterator operator++(int)
         {
             iterator prior(*this);
-            do {
-                index++;
-            } while (index < int32_t(base->slots.size()) && !base->slots.at(index).active);
+            index = base->next_active(index + 1);
             return prior;
         }
         const T &operator*() { return base->at(store_index<T>(index)); }
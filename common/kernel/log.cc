@@ -17,6 +17,7 @@
  *
  */
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <set>
@@ -25,6 +26,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <vector>
+#if !defined(NPNR_DISABLE_THREADS)
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 #include "log.h"
 
@@ -40,9 +48,276 @@ void (*log_error_atexit)() = NULL;
 
 dict<LogLevel, int, loglevel_hash_ops> message_count_by_level;
 static int log_newline_count = 0;
-bool had_nonfatal_error = false;
+std::atomic<bool> had_nonfatal_error{false};
 bool log_warn_as_error = false;
 
+namespace {
+
+// Messages go to the streams either directly from the logging thread, or, while asynchronous logging is on, through a
+// buffer per thread that a background writer drains. Logging threads only ever take the (uncontended) lock of their
+// own buffer, so a thread producing a lot of debug output never waits for I/O or for the other threads.
+//
+// Every message gets a sequence number when it is buffered. The writer only emits messages numbered below the counter
+// value it saw before collecting the buffers, in order, so output is never reordered, even across threads: a message
+// numbered below that value was already in its buffer, as the number is taken under the buffer lock.
+void write_to_sinks(LogLevel level, const std::string &str)
+{
+    for (auto f : log_streams)
+        if (f.second <= level)
+            *f.first << str;
+    if (log_write_function)
+        log_write_function(str);
+}
+
+void flush_sinks()
+{
+    for (auto f : log_streams)
+        f.first->flush();
+}
+
+#if !defined(NPNR_DISABLE_THREADS)
+struct LogRecord
+{
+    uint64_t seq;
+    LogLevel level;
+    std::string text;
+};
+
+struct ThreadLogBuffer
+{
+    std::mutex mutex;
+    std::vector<LogRecord> records;
+    size_t bytes = 0;
+    // Set when the owning thread has exited; the writer frees the buffer once it is empty
+    bool exited = false;
+};
+
+struct AsyncLog
+{
+    // Messages are handed to the writer early once a buffer holds this much
+    static const size_t wake_bytes = 64 * 1024;
+
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> next_seq{0};
+
+    std::mutex registry_mutex;
+    std::vector<ThreadLogBuffer *> buffers;
+
+    // Serialises writing to the streams, between the writer and synchronous flushes
+    std::mutex sink_mutex;
+    std::vector<LogRecord> held;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    bool wake_pending = false, flush_pending = false, stop = false;
+    std::thread writer;
+
+    ThreadLogBuffer *thread_buffer();
+    void push(LogLevel level, std::string &&text, bool urgent);
+    void wake(bool flush);
+    // Write out everything buffered so far; must hold sink_mutex
+    void drain(bool flush);
+    void run_writer();
+};
+
+// Never destroyed, as threads may still log during static destruction
+AsyncLog &async_log()
+{
+    static AsyncLog *state = new AsyncLog;
+    return *state;
+}
+
+struct ThreadLogBufferHandle
+{
+    ThreadLogBuffer *buffer = nullptr;
+    ~ThreadLogBufferHandle()
+    {
+        if (buffer != nullptr) {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            buffer->exited = true;
+        }
+    }
+};
+
+ThreadLogBuffer *AsyncLog::thread_buffer()
+{
+    static thread_local ThreadLogBufferHandle handle;
+    if (handle.buffer == nullptr) {
+        handle.buffer = new ThreadLogBuffer;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffers.push_back(handle.buffer);
+    }
+    return handle.buffer;
+}
+
+void AsyncLog::push(LogLevel level, std::string &&text, bool urgent)
+{
+    ThreadLogBuffer *buf = thread_buffer();
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(buf->mutex);
+        buf->bytes += text.size();
+        buf->records.push_back(LogRecord{next_seq.fetch_add(1), level, std::move(text)});
+        full = buf->bytes >= wake_bytes;
+    }
+    if (urgent || full)
+        wake(urgent);
+}
+
+void AsyncLog::wake(bool flush)
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        if (wake_pending && (flush_pending || !flush))
+            return;
+        wake_pending = true;
+        flush_pending |= flush;
+    }
+    wake_cv.notify_one();
+}
+
+void AsyncLog::drain(bool flush)
+{
+    uint64_t limit = next_seq.load();
+    {
+        std::lock_guard<std::mutex> registry_lock(registry_mutex);
+        for (auto &buf : buffers) {
+            bool remove;
+            {
+                std::lock_guard<std::mutex> lock(buf->mutex);
+                std::move(buf->records.begin(), buf->records.end(), std::back_inserter(held));
+                buf->records.clear();
+                buf->bytes = 0;
+                remove = buf->exited;
+            }
+            if (remove) {
+                delete buf;
+                buf = nullptr;
+            }
+        }
+        buffers.erase(std::remove(buffers.begin(), buffers.end(), nullptr), buffers.end());
+    }
+    std::sort(held.begin(), held.end(), [](const LogRecord &a, const LogRecord &b) { return a.seq < b.seq; });
+    auto end = std::find_if(held.begin(), held.end(), [&](const LogRecord &r) { return r.seq >= limit; });
+    for (auto it = held.begin(); it != end; ++it)
+        write_to_sinks(it->level, it->text);
+    held.erase(held.begin(), end);
+    if (flush)
+        flush_sinks();
+}
+
+void AsyncLog::run_writer()
+{
+    while (true) {
+        bool stopping, flush;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake_cv.wait_for(lock, std::chrono::milliseconds(50), [&] { return wake_pending || stop; });
+            stopping = stop;
+            flush = flush_pending;
+            wake_pending = flush_pending = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(sink_mutex);
+            drain(flush || stopping);
+        }
+        if (stopping)
+            break;
+    }
+}
+#endif
+
+// Write out a formatted message. urgent messages are flushed to the streams promptly
+void emit(LogLevel level, std::string &&str, bool urgent)
+{
+#if !defined(NPNR_DISABLE_THREADS)
+    auto &state = async_log();
+    if (state.enabled.load(std::memory_order_relaxed)) {
+        state.push(level, std::move(str), urgent);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(state.sink_mutex);
+#endif
+    write_to_sinks(level, str);
+    if (urgent)
+        flush_sinks();
+}
+
+#if !defined(NPNR_DISABLE_THREADS)
+std::mutex count_mutex;
+#endif
+
+// Where messages from this thread go instead of the streams, if anywhere; see ScopedLogCapture
+thread_local LogCapture *thread_capture = nullptr;
+
+void update_newline_count(const std::string &str)
+{
+#if !defined(NPNR_DISABLE_THREADS)
+    std::lock_guard<std::mutex> lock(count_mutex);
+#endif
+    size_t nnl_pos = str.find_last_not_of('\n');
+    if (nnl_pos == std::string::npos)
+        log_newline_count += str.size();
+    else
+        log_newline_count = str.size() - nnl_pos - 1;
+}
+
+} // namespace
+
+ScopedLogCapture::ScopedLogCapture(LogCapture &capture) : prev(thread_capture) { thread_capture = &capture; }
+
+ScopedLogCapture::~ScopedLogCapture() { thread_capture = prev; }
+
+void log_replay(const LogCapture &capture, const std::string &prefix)
+{
+    bool line_start = true;
+    for (auto &msg : capture.messages) {
+        std::string str;
+        for (char c : msg.second) {
+            if (line_start && c != '\n')
+                str += prefix;
+            str += c;
+            line_start = (c == '\n');
+        }
+        update_newline_count(str);
+        emit(msg.first, std::move(str), msg.first != LogLevel::LOG_MSG);
+    }
+}
+
+void log_async_start()
+{
+#if !defined(NPNR_DISABLE_THREADS)
+    auto &state = async_log();
+    if (state.enabled)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(state.wake_mutex);
+        state.stop = false;
+    }
+    state.writer = std::thread([&state]() { state.run_writer(); });
+    state.enabled = true;
+#endif
+}
+
+void log_async_stop()
+{
+#if !defined(NPNR_DISABLE_THREADS)
+    auto &state = async_log();
+    if (!state.enabled)
+        return;
+    state.enabled = false;
+    {
+        std::lock_guard<std::mutex> lock(state.wake_mutex);
+        state.stop = true;
+    }
+    state.wake_cv.notify_one();
+    state.writer.join();
+    // Pick up anything buffered while the writer was stopping
+    std::lock_guard<std::mutex> lock(state.sink_mutex);
+    state.drain(true);
+#endif
+}
+
 std::string stringf(const char *fmt, ...)
 {
     std::string string;
@@ -99,22 +374,25 @@ void logv(const char *format, va_list ap, LogLevel level = LogLevel::LOG_MSG)
     if (str.empty())
         return;
 
-    size_t nnl_pos = str.find_last_not_of('\n');
-    if (nnl_pos == std::string::npos)
-        log_newline_count += str.size();
-    else
-        log_newline_count = str.size() - nnl_pos - 1;
+    if (thread_capture != nullptr) {
+        thread_capture->messages.emplace_back(level, std::move(str));
+        return;
+    }
 
-    for (auto f : log_streams)
-        if (f.second <= level)
-            *f.first << str;
-    if (log_write_function)
-        log_write_function(str);
+    update_newline_count(str);
+
+    // Everything but plain log output is shown straight away
+    emit(level, std::move(str), level != LogLevel::LOG_MSG);
 }
 
 void log_with_level(LogLevel level, const char *format, ...)
 {
-    message_count_by_level[level]++;
+    {
+#if !defined(NPNR_DISABLE_THREADS)
+        std::lock_guard<std::mutex> lock(count_mutex);
+#endif
+        message_count_by_level[level]++;
+    }
     va_list ap;
     va_start(ap, format);
     logv(format, ap, level);
@@ -126,18 +404,19 @@ void logv_prefixed(const char *prefix, const char *format, va_list ap, LogLevel
     std::string message = vstringf(format, ap);
 
     log_with_level(level, "%s%s", prefix, message.c_str());
-    log_flush();
 }
 
 void logv_nonfatal_error(const char *format, va_list ap)
 {
     logv_prefixed("ERROR: ", format, ap, LogLevel::ERROR_MSG);
+    log_flush();
     had_nonfatal_error = true;
 }
 
 void logv_error(const char *format, va_list ap)
 {
     logv_prefixed("ERROR: ", format, ap, LogLevel::ERROR_MSG);
+    log_flush();
 
     if (log_error_atexit)
         log_error_atexit();
@@ -205,8 +484,15 @@ void log_nonfatal_error(const char *format, ...)
 
 void log_flush()
 {
-    for (auto f : log_streams)
-        f.first->flush();
+#if !defined(NPNR_DISABLE_THREADS)
+    auto &state = async_log();
+    std::lock_guard<std::mutex> lock(state.sink_mutex);
+    if (state.enabled) {
+        state.drain(true);
+        return;
+    }
+#endif
+    flush_sinks();
 }
 
 NEXTPNR_NAMESPACE_END
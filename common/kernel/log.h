@@ -20,6 +20,7 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <atomic>
 #include <functional>
 #include <ostream>
 #include <set>
@@ -62,7 +63,7 @@ extern log_write_type log_write_function;
 
 extern std::string log_last_error;
 extern void (*log_error_atexit)();
-extern bool had_nonfatal_error;
+extern std::atomic<bool> had_nonfatal_error;
 extern bool log_warn_as_error;
 extern dict<LogLevel, int, loglevel_hash_ops> message_count_by_level;
 
@@ -76,8 +77,49 @@ void log_warning(const char *format, ...) NPNR_ATTRIBUTE(format(printf, 1, 2));
 NPNR_NORETURN void log_error(const char *format, ...) NPNR_ATTRIBUTE(format(printf, 1, 2), noreturn);
 void log_nonfatal_error(const char *format, ...) NPNR_ATTRIBUTE(format(printf, 1, 2));
 void log_break();
+// Write out all buffered messages and flush the log streams
 void log_flush();
 
+// While on, messages are formatted by the logging thread but written to the log streams by a background thread, so
+// that logging from worker threads is cheap and never blocks on I/O. log_streams must not be changed while it is on;
+// log_async_stop() writes out everything still buffered.
+void log_async_start();
+void log_async_stop();
+
+struct ScopedAsyncLog
+{
+    explicit ScopedAsyncLog(bool enable = true)
+    {
+        if (enable)
+            log_async_start();
+    }
+    ~ScopedAsyncLog() { log_async_stop(); }
+    ScopedAsyncLog(const ScopedAsyncLog &) = delete;
+    ScopedAsyncLog &operator=(const ScopedAsyncLog &) = delete;
+};
+
+// Messages logged by a thread while a ScopedLogCapture is alive on it are held in the LogCapture instead of being
+// written out, so that the output of work done in parallel can be kept apart, and written out later with log_replay().
+// They are still counted in message_count_by_level.
+struct LogCapture
+{
+    std::vector<std::pair<LogLevel, std::string>> messages;
+};
+
+struct ScopedLogCapture
+{
+    explicit ScopedLogCapture(LogCapture &capture);
+    ~ScopedLogCapture();
+    ScopedLogCapture(const ScopedLogCapture &) = delete;
+    ScopedLogCapture &operator=(const ScopedLogCapture &) = delete;
+
+  private:
+    LogCapture *prev;
+};
+
+// Write out captured messages, starting each line with prefix
+void log_replay(const LogCapture &capture, const std::string &prefix);
+
 static inline void log_assert_worker(bool cond, const char *expr, const char *file, int line)
 {
     if (!cond)
@@ -352,6 +352,32 @@ struct NetSinkTiming
     delay_t delay;
 };
 
+struct CornerTiming
+{
+    // Achieved and target Fmax for all clock domains at this corner
+    dict<IdString, ClockFmax> clock_fmax;
+    // Worst hold slack within each clock domain at this corner
+    dict<IdString, delay_t> clock_hold_slack;
+};
+
+// Arcs into endpoints capturing data launched by a different clock
+struct ClockCrossing
+{
+    struct Arc
+    {
+        IdString net;
+        // Net driver cell.port
+        std::pair<IdString, IdString> from;
+        // Capturing endpoint cell.port
+        std::pair<IdString, IdString> to;
+    };
+
+    ClockPair clock_pair;
+    // The clocks have no common driver, so paths between them are not timed against each other
+    bool unconstrained;
+    std::vector<Arc> arcs;
+};
+
 struct TimingResult
 {
     // Achieved and target Fmax for all clock domains
@@ -360,6 +386,8 @@ struct TimingResult
     dict<IdString, CriticalPath> clock_paths;
     // Cross-domain critical paths
     std::vector<CriticalPath> xclock_paths;
+    // Next worst paths after the critical path of each domain pair, when requested
+    std::vector<CriticalPath> near_critical_paths;
     // Domains with no interior paths
     pool<IdString> empty_paths;
 
@@ -371,6 +399,12 @@ struct TimingResult
 
     // Histogram of slack
     dict<int, unsigned> slack_histogram;
+
+    // Results for any additional timing corners
+    dict<IdString, CornerTiming> corners;
+
+    // Clock domain crossings, by domain pair
+    std::vector<ClockCrossing> clock_crossings;
 };
 
 // Represents the contents of a non-leaf cell in a design
@@ -0,0 +1,238 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "profiler.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#if !defined(NPNR_DISABLE_THREADS)
+#include <mutex>
+#endif
+
+#include "log.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+std::atomic<bool> profile_is_enabled{false};
+
+namespace {
+
+#if !defined(NPNR_DISABLE_THREADS)
+typedef std::mutex ProfileMutex;
+typedef std::lock_guard<std::mutex> ProfileLock;
+#else
+struct ProfileMutex
+{
+};
+struct ProfileLock
+{
+    explicit ProfileLock(ProfileMutex &) {}
+};
+#endif
+
+struct ProfileEvent
+{
+    const char *name;
+    int64_t begin;
+    // Zone duration in nanoseconds, or -1 for a counter
+    int64_t duration;
+    double value;
+};
+
+struct ThreadProfileBuffer
+{
+    // Events kept per thread before the oldest are overwritten
+    static const size_t capacity = 1 << 16;
+
+    ProfileMutex mutex;
+    int tid;
+    std::vector<ProfileEvent> events;
+    // Once the buffer is full, the index of the oldest event
+    size_t head = 0;
+    size_t dropped = 0;
+    // Set when the owning thread has exited, so the buffer (and its trace lane) can be taken over by a new thread
+    bool exited = false;
+
+    void push(const ProfileEvent &ev)
+    {
+        ProfileLock lock(mutex);
+        if (events.size() < capacity) {
+            events.push_back(ev);
+        } else {
+            events.at(head) = ev;
+            head = (head + 1) % capacity;
+            ++dropped;
+        }
+    }
+
+    void clear()
+    {
+        ProfileLock lock(mutex);
+        events.clear();
+        head = 0;
+        dropped = 0;
+    }
+};
+
+struct ProfileState
+{
+    ProfileMutex registry_mutex;
+    std::vector<ThreadProfileBuffer *> buffers;
+    int main_tid = -1;
+    // steady_clock time of profile_start(), in nanoseconds
+    std::atomic<int64_t> origin{0};
+
+    ThreadProfileBuffer *thread_buffer();
+};
+
+// Never destroyed, as threads may still record events during static destruction
+ProfileState &profile_state()
+{
+    static ProfileState *state = new ProfileState;
+    return *state;
+}
+
+struct ThreadProfileBufferHandle
+{
+    ThreadProfileBuffer *buffer = nullptr;
+    ~ThreadProfileBufferHandle()
+    {
+        if (buffer != nullptr) {
+            ProfileLock lock(buffer->mutex);
+            buffer->exited = true;
+        }
+    }
+};
+
+ThreadProfileBuffer *ProfileState::thread_buffer()
+{
+    static thread_local ThreadProfileBufferHandle handle;
+    if (handle.buffer == nullptr) {
+        ProfileLock registry_lock(registry_mutex);
+        // Short-lived worker threads are common (e.g. one per HeAP solve), so reuse the lanes of exited threads
+        for (auto buf : buffers) {
+            ProfileLock lock(buf->mutex);
+            if (buf->exited) {
+                buf->exited = false;
+                handle.buffer = buf;
+                break;
+            }
+        }
+        if (handle.buffer == nullptr) {
+            handle.buffer = new ThreadProfileBuffer;
+            handle.buffer->tid = int(buffers.size());
+            buffers.push_back(handle.buffer);
+        }
+    }
+    return handle.buffer;
+}
+
+int64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+void write_json_string(std::ostream &out, const char *str)
+{
+    out << '"';
+    for (const char *c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\')
+            out << '\\' << *c;
+        else if (static_cast<unsigned char>(*c) < 0x20)
+            out << stringf("\\u%04x", *c);
+        else
+            out << *c;
+    }
+    out << '"';
+}
+
+// Chrome traces use microseconds
+std::string trace_time(int64_t ns) { return stringf("%.3f", ns / 1000.0); }
+
+} // namespace
+
+void profile_start()
+{
+    auto &state = profile_state();
+    {
+        ProfileLock registry_lock(state.registry_mutex);
+        for (auto buf : state.buffers)
+            buf->clear();
+    }
+    state.main_tid = state.thread_buffer()->tid;
+    state.origin = steady_ns();
+    profile_is_enabled = true;
+}
+
+void profile_stop() { profile_is_enabled = false; }
+
+int64_t profile_now() { return steady_ns() - profile_state().origin.load(std::memory_order_relaxed); }
+
+void profile_record_zone(const char *name, int64_t begin, int64_t end)
+{
+    profile_state().thread_buffer()->push(ProfileEvent{name, begin, end - begin, 0});
+}
+
+void profile_counter(const char *name, double value)
+{
+    if (!profile_enabled())
+        return;
+    profile_state().thread_buffer()->push(ProfileEvent{name, profile_now(), -1, value});
+}
+
+void profile_write_trace(std::ostream &out)
+{
+    auto &state = profile_state();
+    ProfileLock registry_lock(state.registry_mutex);
+    size_t dropped = 0;
+    bool first = true;
+    auto begin_event = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    out << "{\"traceEvents\":[";
+    for (auto buf : state.buffers) {
+        ProfileLock lock(buf->mutex);
+        begin_event();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid << ",\"args\":{\"name\":";
+        write_json_string(out, (buf->tid == state.main_tid) ? "main" : stringf("worker %d", buf->tid).c_str());
+        out << "}}";
+        // Oldest first; viewers sort by time themselves
+        for (size_t i = 0; i < buf->events.size(); i++) {
+            const ProfileEvent &ev = buf->events.at((buf->head + i) % buf->events.size());
+            begin_event();
+            out << "{\"name\":";
+            write_json_string(out, ev.name);
+            if (ev.duration >= 0) {
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid << ",\"ts\":" << trace_time(ev.begin)
+                    << ",\"dur\":" << trace_time(ev.duration) << "}";
+            } else {
+                out << ",\"ph\":\"C\",\"pid\":1,\"tid\":" << buf->tid << ",\"ts\":" << trace_time(ev.begin)
+                    << ",\"args\":{\"value\":" << stringf("%g", ev.value) << "}}";
+            }
+        }
+        dropped += buf->dropped;
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+}
+
+NEXTPNR_NAMESPACE_END
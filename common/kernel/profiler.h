@@ -0,0 +1,82 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// A lightweight profiler for the phases of the flow. Zones are timed with ProfileZone (usually through
+// NPNR_PROFILE_ZONE) and nest by scope, counters record a value over time. Events go to a bounded ring buffer per
+// thread, so the oldest events are dropped on very long runs, and can be written out as a Chrome trace, for
+// chrome://tracing or Perfetto.
+//
+// While the profiler is stopped, a zone costs a single flag check. Zone and counter names are not copied, so must be
+// string literals or otherwise outlive the profiler.
+
+extern std::atomic<bool> profile_is_enabled;
+
+inline bool profile_enabled() { return profile_is_enabled.load(std::memory_order_relaxed); }
+
+// Start recording, discarding events from any earlier run
+void profile_start();
+void profile_stop();
+
+// Nanoseconds since profile_start()
+int64_t profile_now();
+void profile_record_zone(const char *name, int64_t begin, int64_t end);
+void profile_counter(const char *name, double value);
+
+// Write everything recorded as a Chrome trace (JSON object format)
+void profile_write_trace(std::ostream &out);
+
+struct ProfileZone
+{
+    explicit ProfileZone(const char *name) : name(profile_enabled() ? name : nullptr)
+    {
+        if (this->name != nullptr)
+            begin = profile_now();
+    }
+    ~ProfileZone()
+    {
+        if (name != nullptr)
+            profile_record_zone(name, begin, profile_now());
+    }
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+  private:
+    const char *name;
+    int64_t begin = 0;
+};
+
+#define NPNR_PROFILE_CONCAT2(a, b) a##b
+#define NPNR_PROFILE_CONCAT(a, b) NPNR_PROFILE_CONCAT2(a, b)
+// Time the rest of the enclosing scope
+#define NPNR_PROFILE_ZONE(name) ProfileZone NPNR_PROFILE_CONCAT(npnr_profile_zone_, __LINE__)(name)
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* PROFILER_H */
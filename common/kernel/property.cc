@@ -27,14 +27,251 @@ Property::Property() : is_string(false), str(""), intval(0) {}
 
 Property::Property(int64_t intval, int width) : is_string(false), intval(intval)
 {
-    str.reserve(width);
-    for (int i = 0; i < width; i++)
-        str.push_back((intval & (1ULL << i)) ? S1 : S0);
+    NPNR_ASSERT(width >= 0);
+    if (width <= 64) {
+        this->width = width;
+        return;
+    }
+    // Start from all 64 bits of intval
+    this->width = 64;
+    set_width(width);
+    // Values wider than 64 bits are sign extended
+    for (int w = 1; w < word_count(width); w++)
+        word_ref(0, w) = intval < 0 ? ~0ULL : 0ULL;
+    word_ref(0, word_count(width) - 1) &= low_mask(width % 64 ? width % 64 : 64);
 }
 
 Property::Property(const std::string &strval) : is_string(true), str(strval), intval(0xDEADBEEF) {}
 
-Property::Property(State bit) : is_string(false), str(std::string("") + char(bit)), intval(bit == S1) {}
+Property::Property(State bit) : is_string(false), str(""), intval(0) { push_back(bit); }
+
+Property::Property(const Property &other)
+        : is_string(other.is_string), width(other.width), str(other.str), intval(other.intval)
+{
+    if (other.wide) {
+        size_t words = 2 * std::max(word_count(width), 1);
+        wide.reset(new uint64_t[words]);
+        std::copy(other.wide.get(), other.wide.get() + words, wide.get());
+    }
+}
+
+Property::Property(Property &&other)
+        : is_string(other.is_string), width(other.width), str(std::move(other.str)), intval(other.intval),
+          wide(std::move(other.wide))
+{
+    other.width = 0;
+}
+
+Property &Property::operator=(const Property &other)
+{
+    if (this != &other)
+        *this = Property(other);
+    return *this;
+}
+
+Property &Property::operator=(Property &&other)
+{
+    is_string = other.is_string;
+    width = other.width;
+    str = std::move(other.str);
+    intval = other.intval;
+    wide = std::move(other.wide);
+    other.width = 0;
+    return *this;
+}
+
+void Property::make_wide()
+{
+    if (wide)
+        return;
+    wide.reset(new uint64_t[2 * std::max(word_count(width), 1)]());
+    wide[0] = uint64_t(intval) & low_mask(width);
+}
+
+void Property::compact()
+{
+    if (wide && width <= 64 && wide[1] == 0) {
+        intval = int64_t(wide[0]);
+        wide.reset();
+    }
+}
+
+void Property::set_width(int new_width)
+{
+    NPNR_ASSERT(new_width >= 0);
+    // intval alone can only grow if it has no stray bits above the old width, which would become part of the value
+    if (!wide && new_width <= 64 && (new_width <= width || (uint64_t(intval) & ~low_mask(width)) == 0)) {
+        width = new_width;
+        return;
+    }
+    make_wide();
+    int old_words = std::max(word_count(width), 1), new_words = std::max(word_count(new_width), 1);
+    if (new_words != old_words) {
+        std::unique_ptr<uint64_t[]> resized(new uint64_t[2 * new_words]());
+        std::copy(wide.get(), wide.get() + 2 * std::min(old_words, new_words), resized.get());
+        wide = std::move(resized);
+    }
+    width = new_width;
+}
+
+std::vector<bool> Property::as_bits() const
+{
+    NPNR_ASSERT(!is_string);
+    std::vector<bool> result(width);
+    for (int i = 0; i < width; i++)
+        result[i] = (word(0, i >> 6) & ~word(1, i >> 6) & (1ULL << (i & 63))) != 0;
+    return result;
+}
+
+bool Property::as_bool() const
+{
+    if (width <= 64)
+        return intval != 0;
+    for (int w = 0; w < word_count(width); w++)
+        if (word(0, w) & ~word(1, w))
+            return true;
+    return false;
+}
+
+bool Property::is_fully_def() const
+{
+    if (is_string)
+        return false;
+    if (!wide)
+        return true;
+    for (int w = 0; w < word_count(width); w++)
+        if (word(1, w))
+            return false;
+    return true;
+}
+
+void Property::set_bit(int i, State s)
+{
+    NPNR_ASSERT(!is_string && i >= 0 && i < width);
+    uint64_t mask = 1ULL << (i & 63);
+    NPNR_ASSERT(s == S0 || s == S1 || s == Sx || s == Sz);
+    if (!wide && (s == S0 || s == S1)) {
+        uint64_t val = uint64_t(intval) & low_mask(width);
+        intval = int64_t((s == S1) ? (val | mask) : (val & ~mask));
+        return;
+    }
+    uint64_t &val = word_ref(0, i >> 6), &undef = word_ref(1, i >> 6);
+    val = (s == S1 || s == Sz) ? (val | mask) : (val & ~mask);
+    undef = (s == Sx || s == Sz) ? (undef | mask) : (undef & ~mask);
+    if (i < 64)
+        update_intval();
+    compact();
+}
+
+void Property::push_back(State s)
+{
+    NPNR_ASSERT(!is_string);
+    set_width(width + 1);
+    set_bit(width - 1, s);
+}
+
+void Property::resize(int new_width, State padding)
+{
+    NPNR_ASSERT(!is_string);
+    int old_width = width;
+    if (new_width < old_width) {
+        set_width(new_width);
+        // Keep the bits above the width clear
+        int last = new_width / 64;
+        if (wide && last < std::max(word_count(new_width), 1)) {
+            uint64_t mask = low_mask(new_width % 64);
+            wide[2 * last] &= mask;
+            wide[2 * last + 1] &= mask;
+        }
+        if (new_width < 64)
+            update_intval();
+        compact();
+    } else {
+        set_width(new_width);
+        if (padding != S0)
+            for (int i = old_width; i < new_width; i++)
+                set_bit(i, padding);
+    }
+}
+
+uint64_t Property::bits_at(int plane, int offset) const
+{
+    if (offset >= width)
+        return 0;
+    int idx = offset >> 6, shift = offset & 63;
+    uint64_t result = word(plane, idx) >> shift;
+    if (shift != 0 && idx + 1 < word_count(width))
+        result |= word(plane, idx + 1) << (64 - shift);
+    return result;
+}
+
+Property Property::extract(int offset, int len, State padding) const
+{
+    NPNR_ASSERT(offset >= 0 && len >= 0);
+    Property ret;
+    ret.is_string = false;
+    ret.set_width(len);
+    // Copy a word at a time, then fill in any padding above our width
+    for (int w = 0; w < word_count(len); w++) {
+        uint64_t mask = low_mask(len - 64 * w);
+        uint64_t val = bits_at(0, offset + 64 * w) & mask, undef = bits_at(1, offset + 64 * w) & mask;
+        if (len <= 64 && undef == 0) {
+            ret.intval = int64_t(val);
+            continue;
+        }
+        ret.word_ref(0, w) = val;
+        ret.word_ref(1, w) = undef;
+    }
+    if (padding != S0)
+        for (int i = std::max(width - offset, 0); i < len; i++)
+            ret.set_bit(i, padding);
+    ret.update_intval();
+    ret.compact();
+    return ret;
+}
+
+std::string Property::to_bit_string() const
+{
+    NPNR_ASSERT(!is_string);
+    std::string result(width, char(S0));
+    for (int i = 0; i < width; i++)
+        result[i] = char(bit(i));
+    return result;
+}
+
+void Property::set_from_chars(const std::string &chars, bool msb_first)
+{
+    is_string = false;
+    str.clear();
+    wide.reset();
+    intval = 0;
+    width = 0;
+    set_width(int(chars.size()));
+    for (int i = 0; i < width; i++) {
+        char c = msb_first ? chars[width - 1 - i] : chars[i];
+        if (c == S0)
+            continue;
+        NPNR_ASSERT(c == S1 || c == Sx || c == Sz);
+        uint64_t mask = 1ULL << (i & 63);
+        if (c == S1 && !wide && i < 64) {
+            intval = int64_t(uint64_t(intval) | mask);
+            continue;
+        }
+        if (c == S1 || c == Sz)
+            word_ref(0, i >> 6) |= mask;
+        if (c == Sx || c == Sz)
+            word_ref(1, i >> 6) |= mask;
+    }
+    update_intval();
+    compact();
+}
+
+Property Property::from_bit_string(const std::string &bits)
+{
+    Property p;
+    p.set_from_chars(bits, false);
+    return p;
+}
 
 std::string Property::to_string() const
 {
@@ -56,7 +293,10 @@ std::string Property::to_string() const
             result += " ";
         return result;
     } else {
-        return std::string(str.rbegin(), str.rend());
+        std::string result(width, char(S0));
+        for (int i = 0; i < width; i++)
+            result[width - 1 - i] = char(bit(i));
+        return result;
     }
 }
 
@@ -66,9 +306,7 @@ Property Property::from_string(const std::string &s)
 
     size_t cursor = s.find_first_not_of("01xz");
     if (cursor == std::string::npos) {
-        p.str = std::string(s.rbegin(), s.rend());
-        p.is_string = false;
-        p.update_intval();
+        p.set_from_chars(s, true);
     } else if (s.find_first_not_of(' ', cursor) == std::string::npos) {
         p = Property(s.substr(0, s.size() - 1));
     } else {
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -45,40 +46,33 @@ struct Property
     Property(int64_t intval, int width = 32);
     Property(const std::string &strval);
     Property(State bit);
-    Property &operator=(const Property &other) = default;
-    Property(const Property &other) = default;
+    Property &operator=(const Property &other);
+    Property(const Property &other);
+    Property &operator=(Property &&other);
+    Property(Property &&other);
 
     bool is_string;
 
-    // The string literal (for string values), or a string of [01xz] (for numeric values)
+  private:
+    // Numeric width in bits; declared here so that it fits in the padding after is_string
+    int width = 0;
+
+  public:
+    // The string literal, for string values. Empty for numeric values, whose bits are stored packed and accessed
+    // through bit()/set_bit() or to_bit_string()
     std::string str;
     // The lower 64 bits (for numeric values), unused for string values
     int64_t intval;
 
-    void update_intval()
-    {
-        intval = 0;
-        for (int i = 0; i < int(str.size()); i++) {
-            NPNR_ASSERT(str[i] == S0 || str[i] == S1 || str[i] == Sx || str[i] == Sz);
-            if ((str[i] == S1) && i < 64)
-                intval |= (1ULL << i);
-        }
-    }
+    // Recompute intval from the bits; the bit setters already keep it up to date
+    void update_intval() { intval = int64_t(word(0, 0) & ~word(1, 0)); }
 
     int64_t as_int64() const
     {
         NPNR_ASSERT(!is_string);
         return intval;
     }
-    std::vector<bool> as_bits() const
-    {
-        std::vector<bool> result;
-        result.reserve(str.size());
-        NPNR_ASSERT(!is_string);
-        for (auto c : str)
-            result.push_back(c == S1);
-        return result;
-    }
+    std::vector<bool> as_bits() const;
     const std::string &as_string() const
     {
         NPNR_ASSERT(is_string);
@@ -89,43 +83,88 @@ struct Property
         NPNR_ASSERT(is_string);
         return str.c_str();
     }
-    size_t size() const { return is_string ? 8 * str.size() : str.size(); }
+    size_t size() const { return is_string ? 8 * str.size() : size_t(width); }
     double as_double() const
     {
         NPNR_ASSERT(is_string);
         return std::stod(str);
     }
-    bool as_bool() const
-    {
-        if (int(str.size()) <= 64)
-            return intval != 0;
-        else
-            return std::any_of(str.begin(), str.end(), [](char c) { return c == S1; });
-    }
-    bool is_fully_def() const
-    {
-        return !is_string && std::all_of(str.begin(), str.end(), [](char c) { return c == S0 || c == S1; });
-    }
-    Property extract(int offset, int len, State padding = State::S0) const
+    bool as_bool() const;
+    bool is_fully_def() const;
+
+    // Bit access for numeric values, bit 0 being the LSB
+    State bit(int i) const
     {
-        Property ret;
-        ret.is_string = false;
-        ret.str.reserve(len);
-        for (int i = offset; i < offset + len; i++)
-            ret.str.push_back(i < int(str.size()) ? str[i] : char(padding));
-        ret.update_intval();
-        return ret;
+        NPNR_ASSERT(!is_string && i >= 0 && i < width);
+        uint64_t mask = 1ULL << (i & 63);
+        bool val = (word(0, i >> 6) & mask) != 0, undef = (word(1, i >> 6) & mask) != 0;
+        return undef ? (val ? Sz : Sx) : (val ? S1 : S0);
     }
+    void set_bit(int i, State s);
+    // Append a bit at the MSB end
+    void push_back(State s);
+    // Truncate, or extend with padding bits
+    void resize(int new_width, State padding = S0);
+
+    Property extract(int offset, int len, State padding = State::S0) const;
+    // Numeric values as a string of [01xz], LSB first (so index i is bit i), and the inverse
+    std::string to_bit_string() const;
+    static Property from_bit_string(const std::string &bits);
+
     // Convert to a string representation, escaping literal strings matching /^[01xz]* *$/ by adding a space at the end,
     // to disambiguate from binary strings
     std::string to_string() const;
     // Convert a string of four-value binary [01xz], or a literal string escaped according to the above rule
     // to a Property
     static Property from_string(const std::string &s);
-};
 
-inline bool operator==(const Property &a, const Property &b) { return a.is_string == b.is_string && a.str == b.str; }
-inline bool operator!=(const Property &a, const Property &b) { return a.is_string != b.is_string || a.str != b.str; }
+    bool operator==(const Property &other) const
+    {
+        if (is_string != other.is_string)
+            return false;
+        if (is_string)
+            return str == other.str;
+        if (width != other.width)
+            return false;
+        for (int w = 0; w < word_count(width); w++)
+            if (word(0, w) != other.word(0, w) || word(1, w) != other.word(1, w))
+                return false;
+        return true;
+    }
+    bool operator!=(const Property &other) const { return !(*this == other); }
+
+  private:
+    // Numeric values are two bit planes, with 0 = (0, 0), 1 = (1, 0), x = (0, 1) and z = (1, 1) as (val, undef).
+    // Values of up to 64 bits with no x or z bits, which are nearly all parameters, are held in intval alone, whose
+    // bits above the width are ignored. Anything else also has wide, the words of both planes interleaved as val,
+    // undef, val, undef... in which bits above the width are always zero. A Property is 56 bytes, against 48 when values
+    // were strings of bits; the trade-off is that any x or z bit, even a single one as in Property(Sx), now costs a heap
+    // block where the short bit string never did.
+    std::unique_ptr<uint64_t[]> wide;
+
+    static int word_count(int bits) { return (bits + 63) / 64; }
+    static uint64_t low_mask(int bits) { return (bits >= 64) ? ~0ULL : ((1ULL << bits) - 1); }
+    uint64_t word(int plane, int idx) const
+    {
+        if (wide)
+            return wide[2 * idx + plane];
+        return (plane || idx) ? 0 : (uint64_t(intval) & low_mask(width));
+    }
+    // Writable word, switching to wide storage first
+    uint64_t &word_ref(int plane, int idx)
+    {
+        make_wide();
+        return wide[2 * idx + plane];
+    }
+    void make_wide();
+    // Drop wide storage again if intval alone can hold the value
+    void compact();
+    // 64 bits of a plane starting at an arbitrary bit offset, zero above the width
+    uint64_t bits_at(int plane, int offset) const;
+    void set_width(int new_width);
+    // Set a numeric value from a string of [01xz]
+    void set_from_chars(const std::string &chars, bool msb_first);
+};
 
 NEXTPNR_NAMESPACE_END
 
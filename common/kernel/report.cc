@@ -51,52 +51,53 @@ static std::string clock_event_name(const Context *ctx, const ClockEvent &e)
     return value;
 };
 
-static Json::array json_report_critical_paths(const Context *ctx)
+static Json::array json_report_critical_path(const Context *ctx, const CriticalPath &report)
 {
+    Json::array pathJson;
+
+    for (const auto &segment : report.segments) {
+
+        const auto &driver = ctx->cells.at(segment.from.first);
+        const auto &sink = ctx->cells.at(segment.to.first);
+
+        auto fromLoc = ctx->getBelLocation(driver->bel);
+        auto toLoc = ctx->getBelLocation(sink->bel);
+
+        auto fromJson = Json::object({{"cell", segment.from.first.c_str(ctx)},
+                                      {"port", segment.from.second.c_str(ctx)},
+                                      {"loc", Json::array({fromLoc.x, fromLoc.y})}});
+
+        auto toJson = Json::object({{"cell", segment.to.first.c_str(ctx)},
+                                    {"port", segment.to.second.c_str(ctx)},
+                                    {"loc", Json::array({toLoc.x, toLoc.y})}});
+
+        auto segmentJson = Json::object({
+                {"delay", ctx->getDelayNS(segment.delay)},
+                {"from", fromJson},
+                {"to", toJson},
+        });
+
+        if (segment.type == CriticalPath::Segment::Type::CLK_TO_Q) {
+            segmentJson["type"] = "clk-to-q";
+        } else if (segment.type == CriticalPath::Segment::Type::SOURCE) {
+            segmentJson["type"] = "source";
+        } else if (segment.type == CriticalPath::Segment::Type::LOGIC) {
+            segmentJson["type"] = "logic";
+        } else if (segment.type == CriticalPath::Segment::Type::SETUP) {
+            segmentJson["type"] = "setup";
+        } else if (segment.type == CriticalPath::Segment::Type::ROUTING) {
+            segmentJson["type"] = "routing";
+            segmentJson["net"] = segment.net.c_str(ctx);
+        }
 
-    auto report_critical_path = [ctx](const CriticalPath &report) {
-        Json::array pathJson;
-
-        for (const auto &segment : report.segments) {
-
-            const auto &driver = ctx->cells.at(segment.from.first);
-            const auto &sink = ctx->cells.at(segment.to.first);
-
-            auto fromLoc = ctx->getBelLocation(driver->bel);
-            auto toLoc = ctx->getBelLocation(sink->bel);
-
-            auto fromJson = Json::object({{"cell", segment.from.first.c_str(ctx)},
-                                          {"port", segment.from.second.c_str(ctx)},
-                                          {"loc", Json::array({fromLoc.x, fromLoc.y})}});
-
-            auto toJson = Json::object({{"cell", segment.to.first.c_str(ctx)},
-                                        {"port", segment.to.second.c_str(ctx)},
-                                        {"loc", Json::array({toLoc.x, toLoc.y})}});
-
-            auto segmentJson = Json::object({
-                    {"delay", ctx->getDelayNS(segment.delay)},
-                    {"from", fromJson},
-                    {"to", toJson},
-            });
-
-            if (segment.type == CriticalPath::Segment::Type::CLK_TO_Q) {
-                segmentJson["type"] = "clk-to-q";
-            } else if (segment.type == CriticalPath::Segment::Type::SOURCE) {
-                segmentJson["type"] = "source";
-            } else if (segment.type == CriticalPath::Segment::Type::LOGIC) {
-                segmentJson["type"] = "logic";
-            } else if (segment.type == CriticalPath::Segment::Type::SETUP) {
-                segmentJson["type"] = "setup";
-            } else if (segment.type == CriticalPath::Segment::Type::ROUTING) {
-                segmentJson["type"] = "routing";
-                segmentJson["net"] = segment.net.c_str(ctx);
-            }
+        pathJson.push_back(segmentJson);
+    }
 
-            pathJson.push_back(segmentJson);
-        }
+    return pathJson;
+}
 
-        return pathJson;
-    };
+static Json::array json_report_critical_paths(const Context *ctx)
+{
 
     auto critPathsJson = Json::array();
 
@@ -105,19 +106,60 @@ static Json::array json_report_critical_paths(const Context *ctx)
 
         critPathsJson.push_back(Json::object({{"from", clock_event_name(ctx, report.second.clock_pair.start)},
                                               {"to", clock_event_name(ctx, report.second.clock_pair.end)},
-                                              {"path", report_critical_path(report.second)}}));
+                                              {"path", json_report_critical_path(ctx, report.second)}}));
     }
 
     // Cross-domain paths
     for (auto &report : ctx->timing_result.xclock_paths) {
         critPathsJson.push_back(Json::object({{"from", clock_event_name(ctx, report.clock_pair.start)},
                                               {"to", clock_event_name(ctx, report.clock_pair.end)},
-                                              {"path", report_critical_path(report)}}));
+                                              {"path", json_report_critical_path(ctx, report)}}));
     }
 
     return critPathsJson;
 }
 
+static Json::array json_report_near_critical_paths(const Context *ctx)
+{
+    auto nearCritPathsJson = Json::array();
+    dict<std::pair<std::string, std::string>, int> ranks;
+
+    // Paths after the worst for each clock pair, ranked from 2 within their pair
+    for (auto &report : ctx->timing_result.near_critical_paths) {
+        auto from = clock_event_name(ctx, report.clock_pair.start);
+        auto to = clock_event_name(ctx, report.clock_pair.end);
+        int &rank = ranks[std::make_pair(from, to)];
+        if (rank == 0)
+            rank = 1;
+        nearCritPathsJson.push_back(Json::object(
+                {{"from", from}, {"to", to}, {"rank", ++rank}, {"path", json_report_critical_path(ctx, report)}}));
+    }
+
+    return nearCritPathsJson;
+}
+
+static Json::array json_report_clock_crossings(const Context *ctx)
+{
+    auto crossingsJson = Json::array();
+
+    for (auto &crossing : ctx->timing_result.clock_crossings) {
+        Json::array arcsJson;
+        for (auto &arc : crossing.arcs) {
+            arcsJson.push_back(Json::object({
+                    {"net", arc.net.c_str(ctx)},
+                    {"from", Json::object({{"cell", arc.from.first.c_str(ctx)}, {"port", arc.from.second.c_str(ctx)}})},
+                    {"to", Json::object({{"cell", arc.to.first.c_str(ctx)}, {"port", arc.to.second.c_str(ctx)}})},
+            }));
+        }
+        crossingsJson.push_back(Json::object({{"from", clock_event_name(ctx, crossing.clock_pair.start)},
+                                              {"to", clock_event_name(ctx, crossing.clock_pair.end)},
+                                              {"unconstrained", crossing.unconstrained},
+                                              {"arcs", arcsJson}}));
+    }
+
+    return crossingsJson;
+}
+
 static Json::array json_report_detailed_net_timings(const Context *ctx)
 {
     auto detailedNetTimingsJson = Json::array();
@@ -198,6 +240,51 @@ Report JSON structure:
     },
     ...
   ],
+  "corners": {
+    <corner name>: {
+      <clock name>: {
+        "achieved": <achieved fmax at this corner [MHz]>,
+        "constraint": <target fmax [MHz]>,
+        "hold_slack": <worst hold slack at this corner [ns]>
+      },
+      ...
+    },
+    ...
+  },
+  "near_critical_paths": [
+    {
+      "from": <clock event edge and name>,
+      "to": <clock event edge and name>,
+      "rank": <rank of this path within the clock pair, from 2>,
+      "path": [
+        <path segments, as for critical_paths>
+        ...
+      ]
+    },
+    ...
+  ],
+  "clock_crossings": [
+    {
+      "from": <launching clock event edge and name>,
+      "to": <capturing clock event edge and name>,
+      "unconstrained": <true if the clocks are unrelated, so the crossing is not timed>,
+      "arcs": [
+        {
+          "net": <net name>,
+          "from": {
+            "cell": <driver cell name>,
+            "port": <driver port name>
+          },
+          "to": {
+            "cell": <capturing cell name>,
+            "port": <capturing port name>
+          }
+        },
+        ...
+      ]
+    },
+    ...
+  ],
   "detailed_net_timings": [
     {
       "driver": <driving cell name>,
@@ -240,6 +327,30 @@ void Context::writeJsonReport(std::ostream &out) const
     Json::object jsonRoot{
             {"utilization", util_json}, {"fmax", fmax_json}, {"critical_paths", json_report_critical_paths(this)}};
 
+    if (!timing_result.corners.empty()) {
+        dict<std::string, Json> corners_json;
+        for (const auto &corner : timing_result.corners) {
+            dict<std::string, Json> corner_json;
+            for (const auto &kv : corner.second.clock_fmax) {
+                corner_json[kv.first.str(this)] = Json::object{
+                        {"achieved", kv.second.achieved},
+                        {"constraint", kv.second.constraint},
+                        {"hold_slack", getDelayNS(corner.second.clock_hold_slack.at(kv.first))},
+                };
+            }
+            corners_json[corner.first.str(this)] = corner_json;
+        }
+        jsonRoot["corners"] = corners_json;
+    }
+
+    if (!timing_result.near_critical_paths.empty()) {
+        jsonRoot["near_critical_paths"] = json_report_near_critical_paths(this);
+    }
+
+    if (!timing_result.clock_crossings.empty()) {
+        jsonRoot["clock_crossings"] = json_report_clock_crossings(this);
+    }
+
     if (detailed_timing_report) {
         jsonRoot["detailed_net_timings"] = json_report_detailed_net_timings(this);
     }
@@ -18,6 +18,7 @@
  */
 
 #include "nextpnr.h"
+#include "thread_pool.h"
 #include "util.h"
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -76,14 +77,14 @@ struct Interconnect
     RiseFallDelay delay;
 };
 
+// Formats SDF text into string buffers, so that chunks of the file can be formatted in parallel and then written out
+// in order without going through iostream formatting
 struct SDFWriter
 {
     bool cvc_mode = false;
-    std::vector<Cell> cells;
-    std::vector<Interconnect> conn;
     std::string sdfversion, design, vendor, program;
 
-    std::string format_name(const std::string &name)
+    std::string format_name(const std::string &name) const
     {
         std::string fmt = "\"";
         for (char c : name) {
@@ -95,7 +96,7 @@ struct SDFWriter
         return fmt;
     }
 
-    std::string escape_name(const std::string &name)
+    std::string escape_name(const std::string &name) const
     {
         std::string esc;
         for (char c : name) {
@@ -106,7 +107,7 @@ struct SDFWriter
         return esc;
     }
 
-    std::string timing_check_name(TimingCheck::CheckType type)
+    std::string timing_check_name(TimingCheck::CheckType type) const
     {
         switch (type) {
         case TimingCheck::SETUPHOLD:
@@ -120,102 +121,115 @@ struct SDFWriter
         }
     }
 
-    void write_delay(std::ostream &out, const RiseFallDelay &delay)
+    void write_delay(std::string &out, const RiseFallDelay &delay) const
     {
         write_delay(out, delay.rise);
-        out << " ";
+        out += " ";
         write_delay(out, delay.fall);
     }
 
-    void write_delay(std::ostream &out, const MinMaxTyp &delay)
+    void write_delay(std::string &out, const MinMaxTyp &delay) const
     {
+        // %g gives the same output as the default iostream formatting of a double
+        char buf[128];
         if (cvc_mode)
-            out << "(" << int(delay.min) << ":" << int(delay.typ) << ":" << int(delay.max) << ")";
+            snprintf(buf, sizeof(buf), "(%d:%d:%d)", int(delay.min), int(delay.typ), int(delay.max));
         else
-            out << "(" << delay.min << ":" << delay.typ << ":" << delay.max << ")";
+            snprintf(buf, sizeof(buf), "(%g:%g:%g)", delay.min, delay.typ, delay.max);
+        out += buf;
     }
 
-    void write_port(std::ostream &out, const CellPort &port)
+    void write_port(std::string &out, const CellPort &port) const
     {
         if (cvc_mode)
-            out << escape_name(port.cell) + "." + escape_name(port.port);
+            out += escape_name(port.cell) + "." + escape_name(port.port);
         else
-            out << escape_name(port.cell + "/" + port.port);
+            out += escape_name(port.cell + "/" + port.port);
     }
 
-    void write_portedge(std::ostream &out, const PortAndEdge &pe)
+    void write_portedge(std::string &out, const PortAndEdge &pe) const
     {
-        out << "(" << (pe.edge == RISING_EDGE ? "posedge" : "negedge") << " " << escape_name(pe.port) << ")";
+        out += "(";
+        out += (pe.edge == RISING_EDGE ? "posedge" : "negedge");
+        out += " " + escape_name(pe.port) + ")";
     }
 
-    void write(std::ostream &out)
+    void write_header(std::string &out) const
     {
-        out << "(DELAYFILE" << std::endl;
+        out += "(DELAYFILE\n";
         // Headers and  metadata
-        out << "  (SDFVERSION " << format_name(sdfversion) << ")" << std::endl;
-        out << "  (DESIGN " << format_name(design) << ")" << std::endl;
-        out << "  (VENDOR " << format_name(vendor) << ")" << std::endl;
-        out << "  (PROGRAM " << format_name(program) << ")" << std::endl;
-        out << "  (DIVIDER " << (cvc_mode ? "." : "/") << ")" << std::endl;
-        out << "  (TIMESCALE 1ps)" << std::endl;
-        // Write interconnect delays, with the main design begin a "cell"
-        out << "  (CELL" << std::endl;
-        out << "    (CELLTYPE " << format_name(design) << ")" << std::endl;
-        out << "    (INSTANCE )" << std::endl;
-        out << "    (DELAY" << std::endl;
-        out << "      (ABSOLUTE" << std::endl;
-        for (auto &ic : conn) {
-            out << "        (INTERCONNECT ";
-            write_port(out, ic.from);
-            out << " ";
-            write_port(out, ic.to);
-            out << " ";
-            write_delay(out, ic.delay);
-            out << ")" << std::endl;
-        }
-        out << "      )" << std::endl;
-        out << "    )" << std::endl;
-        out << "  )" << std::endl;
-        // Write cells
-        for (auto &cell : cells) {
-            out << "  (CELL" << std::endl;
-            out << "    (CELLTYPE " << format_name(cell.celltype) << ")" << std::endl;
-            out << "    (INSTANCE " << escape_name(cell.instance) << ")" << std::endl;
-            // IOPATHs (combinational delay and clock-to-q)
-            if (!cell.iopaths.empty()) {
-                out << "    (DELAY" << std::endl;
-                out << "      (ABSOLUTE" << std::endl;
-                for (auto &path : cell.iopaths) {
-                    out << "        (IOPATH " << escape_name(path.from) << " " << escape_name(path.to) << " ";
-                    write_delay(out, path.delay);
-                    out << ")" << std::endl;
-                }
-                out << "      )" << std::endl;
-                out << "    )" << std::endl;
+        out += "  (SDFVERSION " + format_name(sdfversion) + ")\n";
+        out += "  (DESIGN " + format_name(design) + ")\n";
+        out += "  (VENDOR " + format_name(vendor) + ")\n";
+        out += "  (PROGRAM " + format_name(program) + ")\n";
+        out += std::string("  (DIVIDER ") + (cvc_mode ? "." : "/") + ")\n";
+        out += "  (TIMESCALE 1ps)\n";
+        // Interconnect delays follow, with the main design begin a "cell"
+        out += "  (CELL\n";
+        out += "    (CELLTYPE " + format_name(design) + ")\n";
+        out += "    (INSTANCE )\n";
+        out += "    (DELAY\n";
+        out += "      (ABSOLUTE\n";
+    }
+
+    void write_interconnect(std::string &out, const Interconnect &ic) const
+    {
+        out += "        (INTERCONNECT ";
+        write_port(out, ic.from);
+        out += " ";
+        write_port(out, ic.to);
+        out += " ";
+        write_delay(out, ic.delay);
+        out += ")\n";
+    }
+
+    void write_interconnect_end(std::string &out) const
+    {
+        out += "      )\n";
+        out += "    )\n";
+        out += "  )\n";
+    }
+
+    void write_cell(std::string &out, const Cell &cell) const
+    {
+        out += "  (CELL\n";
+        out += "    (CELLTYPE " + format_name(cell.celltype) + ")\n";
+        out += "    (INSTANCE " + escape_name(cell.instance) + ")\n";
+        // IOPATHs (combinational delay and clock-to-q)
+        if (!cell.iopaths.empty()) {
+            out += "    (DELAY\n";
+            out += "      (ABSOLUTE\n";
+            for (auto &path : cell.iopaths) {
+                out += "        (IOPATH " + escape_name(path.from) + " " + escape_name(path.to) + " ";
+                write_delay(out, path.delay);
+                out += ")\n";
             }
-            // Timing Checks (setup/hold, period, width)
-            if (!cell.checks.empty()) {
-                out << "    (TIMINGCHECK" << std::endl;
-                for (auto &check : cell.checks) {
-                    out << "      (" << timing_check_name(check.type) << " ";
-                    write_portedge(out, check.from);
-                    out << " ";
-                    if (check.type == TimingCheck::SETUPHOLD) {
-                        write_portedge(out, check.to);
-                        out << " ";
-                    }
-                    if (check.type == TimingCheck::SETUPHOLD)
-                        write_delay(out, check.delay);
-                    else
-                        write_delay(out, check.delay.rise);
-                    out << ")" << std::endl;
+            out += "      )\n";
+            out += "    )\n";
+        }
+        // Timing Checks (setup/hold, period, width)
+        if (!cell.checks.empty()) {
+            out += "    (TIMINGCHECK\n";
+            for (auto &check : cell.checks) {
+                out += "      (" + timing_check_name(check.type) + " ";
+                write_portedge(out, check.from);
+                out += " ";
+                if (check.type == TimingCheck::SETUPHOLD) {
+                    write_portedge(out, check.to);
+                    out += " ";
                 }
-                out << "    )" << std::endl;
+                if (check.type == TimingCheck::SETUPHOLD)
+                    write_delay(out, check.delay);
+                else
+                    write_delay(out, check.delay.rise);
+                out += ")\n";
             }
-            out << "    )" << std::endl;
+            out += "    )\n";
         }
-        out << ")" << std::endl;
+        out += "    )\n";
     }
+
+    void write_footer(std::string &out) const { out += ")\n"; }
 };
 
 } // namespace SDF
@@ -254,9 +268,77 @@ void Context::writeSDF(std::ostream &out, bool cvc_mode) const
         return rf;
     };
 
-    for (const auto &cell : cells) {
+    // Delays are written a chunk of cells or nets at a time, split across the threads (if more than one is configured).
+    // Each thread queries the arch for the delays of its part of the chunk into plain records, and formats them into
+    // its own buffer. The buffers are written out in order, so the output is the same as a serial run, and only one
+    // chunk per thread is ever held in memory. Arches whose timing queries fill caches guard them with a lock.
+    ThreadPool *pool = getThreadPool();
+    std::vector<std::string> buffers(pool ? pool->size() : 1);
+    const int chunk_size = 1024;
+    auto write_chunked = [&](int count, auto &records, auto extract_item, auto format_record) {
+        int parts = int(buffers.size());
+        int total_chunk = chunk_size * parts;
+        for (int begin = 0; begin < count; begin += total_chunk) {
+            int end = std::min(count, begin + total_chunk);
+            auto do_part = [&](int part) {
+                auto &buf = buffers.at(part);
+                auto &part_records = records.at(part);
+                buf.clear();
+                part_records.clear();
+                int part_begin = begin + ((end - begin) * part) / parts;
+                int part_end = begin + ((end - begin) * (part + 1)) / parts;
+                for (int i = part_begin; i < part_end; i++)
+                    extract_item(i, part_records);
+                for (auto &record : part_records)
+                    format_record(record, buf);
+            };
+            if (pool)
+                pool->run(parts, do_part);
+            else
+                do_part(0);
+            for (auto &buf : buffers)
+                out.write(buf.data(), buf.size());
+        }
+    };
+
+    std::string header;
+    wr.write_header(header);
+    out.write(header.data(), header.size());
+
+    std::vector<const NetInfo *> net_list;
+    net_list.reserve(nets.size());
+    for (auto &net : nets)
+        net_list.push_back(net.second.get());
+    auto extract_net = [&](int i, std::vector<Interconnect> &records) {
+        const NetInfo *ni = net_list.at(i);
+        if (ni->driver.cell == nullptr)
+            return;
+        for (auto &usr : ni->users) {
+            Interconnect ic;
+            ic.from.cell = ni->driver.cell->name.str(this);
+            ic.from.port = ni->driver.port.str(this);
+            ic.to.cell = usr.cell->name.str(this);
+            ic.to.port = usr.port.str(this);
+            // FIXME: min/max routing delay
+            ic.delay = convert_delay(getNetinfoRouteDelayQuad(ni, usr));
+            records.push_back(ic);
+        }
+    };
+    std::vector<std::vector<Interconnect>> interconnects(buffers.size());
+    write_chunked(int(net_list.size()), interconnects, extract_net,
+                  [&](const Interconnect &ic, std::string &buf) { wr.write_interconnect(buf, ic); });
+
+    std::string interconnect_end;
+    wr.write_interconnect_end(interconnect_end);
+    out.write(interconnect_end.data(), interconnect_end.size());
+
+    std::vector<const CellInfo *> cell_list;
+    cell_list.reserve(cells.size());
+    for (auto &cell : cells)
+        cell_list.push_back(cell.second.get());
+    auto extract_cell = [&](int i, std::vector<Cell> &records) {
         Cell sc;
-        const CellInfo *ci = cell.second.get();
+        const CellInfo *ci = cell_list.at(i);
         sc.instance = ci->name.str(this);
         sc.celltype = ci->type.str(this);
         for (auto port : ci->ports) {
@@ -310,25 +392,15 @@ void Context::writeSDF(std::ostream &out, bool cvc_mode) const
                 }
             }
         }
-        wr.cells.push_back(sc);
-    }
+        records.push_back(std::move(sc));
+    };
+    std::vector<std::vector<Cell>> cell_records(buffers.size());
+    write_chunked(int(cell_list.size()), cell_records, extract_cell,
+                  [&](const Cell &sc, std::string &buf) { wr.write_cell(buf, sc); });
 
-    for (auto &net : nets) {
-        NetInfo *ni = net.second.get();
-        if (ni->driver.cell == nullptr)
-            continue;
-        for (auto &usr : ni->users) {
-            Interconnect ic;
-            ic.from.cell = ni->driver.cell->name.str(this);
-            ic.from.port = ni->driver.port.str(this);
-            ic.to.cell = usr.cell->name.str(this);
-            ic.to.port = usr.port.str(this);
-            // FIXME: min/max routing delay
-            ic.delay = convert_delay(getNetinfoRouteDelayQuad(ni, usr));
-            wr.conn.push_back(ic);
-        }
-    }
-    wr.write(out);
+    std::string footer;
+    wr.write_footer(footer);
+    out.write(footer.data(), footer.size());
 }
 
 NEXTPNR_NAMESPACE_END
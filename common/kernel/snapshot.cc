@@ -0,0 +1,862 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <algorithm>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include "base_clusterinfo.h"
+#include "log.h"
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+/*
+Binary snapshot of the design held by a Context, for reloading the state after packing or placement much faster than
+from JSON. Unlike JSON, it also keeps the relative placement constraints set up by the packer. Integers are
+little-endian. Names are uint32 indices into the string table; bels, wires and pips are stored by name, as a uint32
+count (0 for none) followed by that many names. Snapshots are only meant to be read back by the same build of nextpnr,
+for the same device.
+
+    header:       char[8] "NPNRSNAP", uint32 version, then the arch and device name, each as uint32 length and bytes
+    strings:      count; per string: uint32 length, bytes (not terminated), in the order they were created
+    context:      uint8 design_loaded, uint64 RNG state, top_module, properties settings, properties attrs
+    regions:      count; name, uint8 constrained (bit 0 bels, 1 wires, 2 pips), bels, wires, pip locations
+    nets:         count; name, hierpath, int32 udata, properties attrs, constant_value, aliases, region,
+                  uint8 has clock constraint (then float64 high min/max, low min/max, period min/max)
+    cells:        count; name, type, hierpath, int32 udata, properties attrs, properties params, cluster, region,
+                  ports (count; name, uint8 type, net), bel, uint8 bel strength
+    connectivity: per net, in order: driver cell, driver port, users (count; cell, port)
+    clusters:     only for arches using BaseClusterInfo; per cell, in order: constr_children (count; cell),
+                  int32 constr_x, constr_y, constr_z, uint8 constr_abs_z
+    net aliases:  count; alias, net
+    top ports:    count; name, uint8 type, net; then port cells: count; port name, cell
+    hierarchy:    count; path, name, type, parent, fullpath, the leaf_cells, nets, leaf_cells_by_gname and
+                  nets_by_gname maps, ports (count; key, name, uint8 dir, nets, int32 offset, uint8 upto), the
+                  hier_cells map
+    routing:      per net, in order: count; wire, pip, uint8 strength
+    properties:   count; name, uint8 is_string, then either uint32 length and bytes, or uint32 width, int64 intval and
+                  the bits as [01xz] characters
+*/
+
+namespace {
+const char snapshot_magic[8] = {'N', 'P', 'N', 'R', 'S', 'N', 'A', 'P'};
+const uint32_t snapshot_version = 1;
+
+// hashlib containers iterate over the newest entry first. Writing them out oldest first means that inserting the
+// entries in file order recreates the same iteration order, which keeps everything after a restore deterministic
+template <typename T> auto insertion_order(const T &container)
+{
+    std::vector<decltype(&*container.begin())> order;
+    order.reserve(container.size());
+    for (auto &entry : container)
+        order.push_back(&entry);
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+struct SnapshotWriter
+{
+    const Context *ctx;
+    std::vector<uint8_t> body;
+    std::vector<IdString> strings;
+    dict<IdString, uint32_t> string_index;
+    // Offsets in body of every string index, to be renumbered by finish()
+    std::vector<size_t> id_offsets;
+
+    explicit SnapshotWriter(const Context *ctx) : ctx(ctx){};
+
+    void write_u8(uint8_t value) { body.push_back(value); }
+
+    void write_u32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            body.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    uint32_t read_u32_at(size_t offset) const
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++)
+            value |= uint32_t(body.at(offset + i)) << (8 * i);
+        return value;
+    }
+
+    void write_u64(uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+            body.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    void write_f64(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write_u64(bits);
+    }
+
+    void write_str(const std::string &str)
+    {
+        write_u32(uint32_t(str.size()));
+        body.insert(body.end(), str.begin(), str.end());
+    }
+
+    void write_id(IdString id)
+    {
+        auto fnd = string_index.find(id);
+        if (fnd == string_index.end()) {
+            fnd = string_index.emplace(id, uint32_t(strings.size())).first;
+            strings.push_back(id);
+        }
+        id_offsets.push_back(body.size());
+        write_u32(fnd->second);
+    }
+
+    void write_ids(const std::vector<IdString> &ids)
+    {
+        write_u32(uint32_t(ids.size()));
+        for (auto id : ids)
+            write_id(id);
+    }
+
+    void write_id_map(const dict<IdString, IdString> &map)
+    {
+        write_u32(uint32_t(map.size()));
+        for (auto entry : insertion_order(map)) {
+            write_id(entry->first);
+            write_id(entry->second);
+        }
+    }
+
+    void write_name(const IdStringList &name)
+    {
+        write_u32(uint32_t(name.size()));
+        for (auto id : name)
+            write_id(id);
+    }
+
+    void write_bel(BelId bel)
+    {
+        if (bel == BelId())
+            write_u32(0);
+        else
+            write_name(ctx->getBelName(bel));
+    }
+
+    void write_wire(WireId wire)
+    {
+        if (wire == WireId())
+            write_u32(0);
+        else
+            write_name(ctx->getWireName(wire));
+    }
+
+    void write_pip(PipId pip)
+    {
+        if (pip == PipId())
+            write_u32(0);
+        else
+            write_name(ctx->getPipName(pip));
+    }
+
+    void write_delay(DelayPair delay)
+    {
+        write_f64(delay.min_delay);
+        write_f64(delay.max_delay);
+    }
+
+    void write_properties(const dict<IdString, Property> &props)
+    {
+        write_u32(uint32_t(props.size()));
+        for (auto prop : insertion_order(props)) {
+            write_id(prop->first);
+            write_u8(prop->second.is_string);
+            if (prop->second.is_string) {
+                write_str(prop->second.as_string());
+            } else {
+                write_u32(uint32_t(prop->second.size()));
+                write_u64(uint64_t(prop->second.intval));
+                std::string bits = prop->second.to_bit_string();
+                body.insert(body.end(), bits.begin(), bits.end());
+            }
+        }
+    }
+
+    std::vector<uint8_t> finish()
+    {
+        // Some code orders by IdString, so the table is kept in creation order. Loading it into a new process then
+        // creates the strings in the same relative order.
+        std::vector<uint32_t> sorted(strings.size()), renumber(strings.size());
+        for (uint32_t i = 0; i < sorted.size(); i++)
+            sorted[i] = i;
+        std::sort(sorted.begin(), sorted.end(),
+                  [&](uint32_t a, uint32_t b) { return strings.at(a).index < strings.at(b).index; });
+        for (uint32_t i = 0; i < sorted.size(); i++)
+            renumber[sorted[i]] = i;
+        for (size_t offset : id_offsets) {
+            uint32_t idx = renumber.at(read_u32_at(offset));
+            for (int i = 0; i < 4; i++)
+                body[offset + i] = uint8_t(idx >> (8 * i));
+        }
+        std::vector<IdString> old_strings;
+        std::swap(strings, old_strings);
+        for (uint32_t idx : sorted)
+            strings.push_back(old_strings.at(idx));
+
+        // The string table goes ahead of everything written so far
+        std::vector<uint8_t> content;
+        std::swap(body, content);
+        for (char c : snapshot_magic)
+            write_u8(uint8_t(c));
+        write_u32(snapshot_version);
+        write_str(ctx->archId().str(ctx));
+        write_str(ctx->archArgsToId(ctx->archArgs()).str(ctx));
+        write_u32(uint32_t(strings.size()));
+        for (auto id : strings)
+            write_str(id.str(ctx));
+        body.insert(body.end(), content.begin(), content.end());
+        return std::move(body);
+    }
+};
+
+struct SnapshotReader
+{
+    Context *ctx;
+    const uint8_t *data;
+    size_t size, pos = 0;
+    std::vector<IdString> strings;
+
+    SnapshotReader(Context *ctx, const uint8_t *data, size_t size) : ctx(ctx), data(data), size(size){};
+
+    const uint8_t *take(size_t count)
+    {
+        if (count > size - pos)
+            log_error("Design snapshot is truncated.\n");
+        const uint8_t *ptr = data + pos;
+        pos += count;
+        return ptr;
+    }
+
+    uint8_t read_u8() { return *take(1); }
+
+    uint32_t read_u32()
+    {
+        const uint8_t *buf = take(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++)
+            value |= uint32_t(buf[i]) << (8 * i);
+        return value;
+    }
+
+    uint64_t read_u64()
+    {
+        const uint8_t *buf = take(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++)
+            value |= uint64_t(buf[i]) << (8 * i);
+        return value;
+    }
+
+    double read_f64()
+    {
+        uint64_t bits = read_u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string read_str()
+    {
+        uint32_t len = read_u32();
+        const uint8_t *buf = take(len);
+        return std::string(reinterpret_cast<const char *>(buf), len);
+    }
+
+    IdString read_id()
+    {
+        uint32_t idx = read_u32();
+        if (idx >= strings.size())
+            log_error("Design snapshot has an invalid string index.\n");
+        return strings[idx];
+    }
+
+    // Read an element count, checking that the elements (of at least min_size bytes each) could fit
+    uint32_t read_count(size_t min_size)
+    {
+        uint32_t count = read_u32();
+        if (count > (size - pos) / min_size)
+            log_error("Design snapshot is truncated.\n");
+        return count;
+    }
+
+    std::vector<IdString> read_ids()
+    {
+        std::vector<IdString> ids(read_count(4));
+        for (auto &id : ids)
+            id = read_id();
+        return ids;
+    }
+
+    void read_id_map(dict<IdString, IdString> &map)
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            IdString key = read_id();
+            map[key] = read_id();
+        }
+    }
+
+    // Returns false for an empty name, i.e. a null bel, wire or pip
+    bool read_name(IdStringList &name)
+    {
+        std::vector<IdString> ids = read_ids();
+        if (ids.empty())
+            return false;
+        name = IdStringList(ids);
+        return true;
+    }
+
+    BelId read_bel()
+    {
+        IdStringList name;
+        if (!read_name(name))
+            return BelId();
+        BelId bel = ctx->getBelByName(name);
+        if (bel == BelId())
+            log_error("Design snapshot refers to bel '%s', which doesn't exist.\n", name.str(ctx).c_str());
+        return bel;
+    }
+
+    WireId read_wire()
+    {
+        IdStringList name;
+        if (!read_name(name))
+            return WireId();
+        WireId wire = ctx->getWireByName(name);
+        if (wire == WireId())
+            log_error("Design snapshot refers to wire '%s', which doesn't exist.\n", name.str(ctx).c_str());
+        return wire;
+    }
+
+    PipId read_pip()
+    {
+        IdStringList name;
+        if (!read_name(name))
+            return PipId();
+        PipId pip = ctx->getPipByName(name);
+        if (pip == PipId())
+            log_error("Design snapshot refers to pip '%s', which doesn't exist.\n", name.str(ctx).c_str());
+        return pip;
+    }
+
+    DelayPair read_delay()
+    {
+        DelayPair delay;
+        delay.min_delay = delay_t(read_f64());
+        delay.max_delay = delay_t(read_f64());
+        return delay;
+    }
+
+    void read_properties(dict<IdString, Property> &props)
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            IdString name = read_id();
+            if (read_u8()) {
+                props[name] = Property(read_str());
+            } else {
+                uint32_t width = read_u32();
+                int64_t intval = int64_t(read_u64());
+                const uint8_t *bits = take(width);
+                Property value = Property::from_bit_string(std::string(reinterpret_cast<const char *>(bits), width));
+                value.intval = intval;
+                props[name] = std::move(value);
+            }
+        }
+    }
+
+    NetInfo *read_net()
+    {
+        IdString name = read_id();
+        if (name == IdString())
+            return nullptr;
+        auto fnd = ctx->nets.find(name);
+        if (fnd == ctx->nets.end())
+            log_error("Design snapshot refers to net '%s', which doesn't exist.\n", name.c_str(ctx));
+        return fnd->second.get();
+    }
+
+    CellInfo *read_cell()
+    {
+        IdString name = read_id();
+        if (name == IdString())
+            return nullptr;
+        auto fnd = ctx->cells.find(name);
+        if (fnd == ctx->cells.end())
+            log_error("Design snapshot refers to cell '%s', which doesn't exist.\n", name.c_str(ctx));
+        return fnd->second.get();
+    }
+
+    Region *read_region()
+    {
+        IdString name = read_id();
+        if (name == IdString())
+            return nullptr;
+        auto fnd = ctx->region.find(name);
+        if (fnd == ctx->region.end())
+            log_error("Design snapshot refers to region '%s', which doesn't exist.\n", name.c_str(ctx));
+        return fnd->second.get();
+    }
+
+    void read_header()
+    {
+        if (size < sizeof(snapshot_magic) || std::memcmp(data, snapshot_magic, sizeof(snapshot_magic)) != 0)
+            log_error("Not a nextpnr design snapshot.\n");
+        take(sizeof(snapshot_magic));
+        uint32_t version = read_u32();
+        if (version != snapshot_version)
+            log_error("Design snapshot has version %u, but only version %u is supported.\n", version,
+                      snapshot_version);
+        std::string arch = read_str(), device = read_str();
+        std::string this_arch = ctx->archId().str(ctx), this_device = ctx->archArgsToId(ctx->archArgs()).str(ctx);
+        if (arch != this_arch || device != this_device)
+            log_error("Design snapshot is for %s device '%s', not %s device '%s'.\n", arch.c_str(), device.c_str(),
+                      this_arch.c_str(), this_device.c_str());
+        uint32_t count = read_count(4);
+        strings.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+            strings.push_back(ctx->id(read_str()));
+    }
+};
+
+// The relative constraints of BaseClusterInfo are set up by the packer and can't be recreated by assignArchInfo, so
+// are stored for the arches that use it
+template <typename TCell, bool = std::is_base_of<BaseClusterInfo, TCell>::value> struct SnapshotClusters
+{
+    static void write(SnapshotWriter &w, const TCell *ci)
+    {
+        w.write_u32(uint32_t(ci->constr_children.size()));
+        for (auto child : ci->constr_children)
+            w.write_id(child->name);
+        w.write_u32(uint32_t(ci->constr_x));
+        w.write_u32(uint32_t(ci->constr_y));
+        w.write_u32(uint32_t(ci->constr_z));
+        w.write_u8(ci->constr_abs_z);
+    }
+
+    static void read(SnapshotReader &r, TCell *ci)
+    {
+        uint32_t child_count = r.read_count(4);
+        ci->constr_children.clear();
+        for (uint32_t i = 0; i < child_count; i++) {
+            CellInfo *child = r.read_cell();
+            if (child == nullptr)
+                log_error("Design snapshot has an invalid cluster child of cell '%s'.\n", ci->name.c_str(r.ctx));
+            ci->constr_children.push_back(child);
+        }
+        ci->constr_x = int32_t(r.read_u32());
+        ci->constr_y = int32_t(r.read_u32());
+        ci->constr_z = int32_t(r.read_u32());
+        ci->constr_abs_z = r.read_u8();
+    }
+};
+
+template <typename TCell> struct SnapshotClusters<TCell, false>
+{
+    static void write(SnapshotWriter &, const TCell *) {}
+    static void read(SnapshotReader &, TCell *) {}
+};
+
+// Remove the design from the Context, including its bindings in the Arch
+void clear_design(Context *ctx)
+{
+    for (auto &net : ctx->nets) {
+        std::vector<WireId> to_unbind;
+        for (auto &wire : net.second->wires)
+            to_unbind.push_back(wire.first);
+        for (auto wire : to_unbind)
+            ctx->unbindWire(wire);
+    }
+    for (auto &cell : ctx->cells)
+        if (cell.second->bel != BelId())
+            ctx->unbindBel(cell.second->bel);
+    ctx->cells.clear();
+    ctx->nets.clear();
+    ctx->net_aliases.clear();
+    ctx->hierarchy.clear();
+    ctx->ports.clear();
+    ctx->port_cells.clear();
+    ctx->region.clear();
+    ctx->settings.clear();
+    ctx->attrs.clear();
+    ctx->timing_result = TimingResult();
+}
+} // namespace
+
+std::vector<uint8_t> Context::saveSnapshot() const
+{
+    SnapshotWriter w(this);
+    w.write_u8(design_loaded);
+    w.write_u64(rngstate);
+    w.write_id(top_module);
+    w.write_properties(settings);
+    w.write_properties(attrs);
+
+    w.write_u32(uint32_t(region.size()));
+    for (auto entry : insertion_order(region)) {
+        const Region *r = entry->second.get();
+        w.write_id(r->name);
+        w.write_u8(uint8_t(r->constr_bels) | (uint8_t(r->constr_wires) << 1) | (uint8_t(r->constr_pips) << 2));
+        w.write_u32(uint32_t(r->bels.size()));
+        for (auto bel : insertion_order(r->bels))
+            w.write_bel(*bel);
+        w.write_u32(uint32_t(r->wires.size()));
+        for (auto wire : insertion_order(r->wires))
+            w.write_wire(*wire);
+        w.write_u32(uint32_t(r->piplocs.size()));
+        for (auto loc : insertion_order(r->piplocs)) {
+            w.write_u32(uint32_t(loc->x));
+            w.write_u32(uint32_t(loc->y));
+            w.write_u32(uint32_t(loc->z));
+        }
+    }
+
+    auto net_order = insertion_order(nets);
+    w.write_u32(uint32_t(nets.size()));
+    for (auto net : net_order) {
+        const NetInfo *ni = net->second.get();
+        w.write_id(ni->name);
+        w.write_id(ni->hierpath);
+        w.write_u32(uint32_t(ni->udata));
+        w.write_properties(ni->attrs);
+        w.write_id(ni->constant_value);
+        w.write_ids(ni->aliases);
+        w.write_id(ni->region ? ni->region->name : IdString());
+        w.write_u8(bool(ni->clkconstr));
+        if (ni->clkconstr) {
+            w.write_delay(ni->clkconstr->high);
+            w.write_delay(ni->clkconstr->low);
+            w.write_delay(ni->clkconstr->period);
+        }
+    }
+
+    auto cell_order = insertion_order(cells);
+    w.write_u32(uint32_t(cells.size()));
+    for (auto cell : cell_order) {
+        const CellInfo *ci = cell->second.get();
+        if (ci->isPseudo())
+            log_error("Cell '%s' is a pseudo cell, which can't be stored in a design snapshot.\n", nameOf(ci));
+        w.write_id(ci->name);
+        w.write_id(ci->type);
+        w.write_id(ci->hierpath);
+        w.write_u32(uint32_t(ci->udata));
+        w.write_properties(ci->attrs);
+        w.write_properties(ci->params);
+        w.write_id(ci->cluster);
+        w.write_id(ci->region ? ci->region->name : IdString());
+        w.write_u32(uint32_t(ci->ports.size()));
+        for (auto port : insertion_order(ci->ports)) {
+            w.write_id(port->first);
+            w.write_u8(uint8_t(port->second.type));
+            w.write_id(port->second.net ? port->second.net->name : IdString());
+        }
+        w.write_bel(ci->bel);
+        w.write_u8(uint8_t(ci->belStrength));
+    }
+
+    for (auto net : net_order) {
+        const NetInfo *ni = net->second.get();
+        w.write_id(ni->driver.cell ? ni->driver.cell->name : IdString());
+        w.write_id(ni->driver.port);
+        w.write_u32(uint32_t(ni->users.entries()));
+        for (auto &usr : ni->users) {
+            w.write_id(usr.cell->name);
+            w.write_id(usr.port);
+        }
+    }
+
+    for (auto cell : cell_order)
+        SnapshotClusters<CellInfo>::write(w, cell->second.get());
+
+    w.write_id_map(net_aliases);
+
+    w.write_u32(uint32_t(ports.size()));
+    for (auto port : insertion_order(ports)) {
+        w.write_id(port->first);
+        w.write_u8(uint8_t(port->second.type));
+        w.write_id(port->second.net ? port->second.net->name : IdString());
+    }
+    // Packing may remove the cells recorded here without updating port_cells, so only keep those still in the design
+    pool<const CellInfo *, hash_ptr_ops> live_cells;
+    for (auto &cell : cells)
+        live_cells.insert(cell.second.get());
+    std::vector<std::pair<IdString, IdString>> live_port_cells;
+    for (auto port : insertion_order(port_cells))
+        if (live_cells.count(port->second))
+            live_port_cells.emplace_back(port->first, port->second->name);
+    w.write_u32(uint32_t(live_port_cells.size()));
+    for (auto &port : live_port_cells) {
+        w.write_id(port.first);
+        w.write_id(port.second);
+    }
+
+    w.write_u32(uint32_t(hierarchy.size()));
+    for (auto entry : insertion_order(hierarchy)) {
+        const HierarchicalCell &hc = entry->second;
+        w.write_id(entry->first);
+        w.write_id(hc.name);
+        w.write_id(hc.type);
+        w.write_id(hc.parent);
+        w.write_id(hc.fullpath);
+        w.write_id_map(hc.leaf_cells);
+        w.write_id_map(hc.nets);
+        w.write_id_map(hc.leaf_cells_by_gname);
+        w.write_id_map(hc.nets_by_gname);
+        w.write_u32(uint32_t(hc.ports.size()));
+        for (auto port : insertion_order(hc.ports)) {
+            w.write_id(port->first);
+            w.write_id(port->second.name);
+            w.write_u8(uint8_t(port->second.dir));
+            w.write_ids(port->second.nets);
+            w.write_u32(uint32_t(port->second.offset));
+            w.write_u8(port->second.upto);
+        }
+        w.write_id_map(hc.hier_cells);
+    }
+
+    for (auto net : net_order) {
+        const NetInfo *ni = net->second.get();
+        w.write_u32(uint32_t(ni->wires.size()));
+        for (auto wire : insertion_order(ni->wires)) {
+            w.write_wire(wire->first);
+            w.write_pip(wire->second.pip);
+            w.write_u8(uint8_t(wire->second.strength));
+        }
+    }
+
+    return w.finish();
+}
+
+void Context::restoreSnapshot(const uint8_t *data, size_t size)
+{
+    SnapshotReader r(this, data, size);
+    r.read_header();
+    clear_design(this);
+
+    design_loaded = r.read_u8();
+    rngstate = r.read_u64();
+    top_module = r.read_id();
+    r.read_properties(settings);
+    r.read_properties(attrs);
+
+    uint32_t region_count = r.read_u32();
+    for (uint32_t i = 0; i < region_count; i++) {
+        auto reg = std::make_unique<Region>();
+        reg->name = r.read_id();
+        uint8_t constr = r.read_u8();
+        reg->constr_bels = (constr & 1) != 0;
+        reg->constr_wires = (constr & 2) != 0;
+        reg->constr_pips = (constr & 4) != 0;
+        uint32_t count = r.read_u32();
+        for (uint32_t j = 0; j < count; j++)
+            reg->bels.insert(r.read_bel());
+        count = r.read_u32();
+        for (uint32_t j = 0; j < count; j++)
+            reg->wires.insert(r.read_wire());
+        count = r.read_u32();
+        for (uint32_t j = 0; j < count; j++) {
+            Loc loc;
+            loc.x = int32_t(r.read_u32());
+            loc.y = int32_t(r.read_u32());
+            loc.z = int32_t(r.read_u32());
+            reg->piplocs.insert(loc);
+        }
+        IdString name = reg->name;
+        region[name] = std::move(reg);
+    }
+
+    uint32_t net_count = r.read_u32();
+    std::vector<NetInfo *> net_order;
+    net_order.reserve(net_count);
+    nets.reserve(net_count);
+    for (uint32_t i = 0; i < net_count; i++) {
+        IdString name = r.read_id();
+        auto net = std::make_unique<NetInfo>(name);
+        net->hierpath = r.read_id();
+        net->udata = int32_t(r.read_u32());
+        r.read_properties(net->attrs);
+        net->constant_value = r.read_id();
+        net->aliases = r.read_ids();
+        net->region = r.read_region();
+        if (r.read_u8()) {
+            net->clkconstr = std::make_unique<ClockConstraint>();
+            net->clkconstr->high = r.read_delay();
+            net->clkconstr->low = r.read_delay();
+            net->clkconstr->period = r.read_delay();
+        }
+        net_order.push_back(net.get());
+        nets[name] = std::move(net);
+    }
+
+    uint32_t cell_count = r.read_u32();
+    std::vector<CellInfo *> cell_order;
+    std::vector<std::pair<CellInfo *, BelId>> placement;
+    std::vector<PlaceStrength> placement_strength;
+    cells.reserve(cell_count);
+    for (uint32_t i = 0; i < cell_count; i++) {
+        IdString name = r.read_id();
+        IdString type = r.read_id();
+        auto cell = std::make_unique<CellInfo>(this, name, type);
+        cell->hierpath = r.read_id();
+        cell->udata = int32_t(r.read_u32());
+        r.read_properties(cell->attrs);
+        r.read_properties(cell->params);
+        cell->cluster = r.read_id();
+        cell->region = r.read_region();
+        uint32_t port_count = r.read_u32();
+        for (uint32_t j = 0; j < port_count; j++) {
+            IdString port_name = r.read_id();
+            auto &port = cell->ports[port_name];
+            port.name = port_name;
+            port.type = PortType(r.read_u8());
+            port.net = r.read_net();
+        }
+        BelId bel = r.read_bel();
+        PlaceStrength strength = PlaceStrength(r.read_u8());
+        if (bel != BelId()) {
+            placement.emplace_back(cell.get(), bel);
+            placement_strength.push_back(strength);
+        }
+        cell_order.push_back(cell.get());
+        cells[name] = std::move(cell);
+    }
+
+    for (NetInfo *ni : net_order) {
+        ni->driver.cell = r.read_cell();
+        ni->driver.port = r.read_id();
+        uint32_t user_count = r.read_u32();
+        for (uint32_t j = 0; j < user_count; j++) {
+            PortRef usr;
+            usr.cell = r.read_cell();
+            usr.port = r.read_id();
+            if (usr.cell == nullptr || !usr.cell->ports.count(usr.port))
+                log_error("Design snapshot has an invalid user of net '%s'.\n", nameOf(ni));
+            usr.cell->ports.at(usr.port).user_idx = ni->users.add(usr);
+        }
+    }
+
+    for (CellInfo *ci : cell_order)
+        SnapshotClusters<CellInfo>::read(r, ci);
+
+    r.read_id_map(net_aliases);
+
+    uint32_t port_count = r.read_u32();
+    for (uint32_t i = 0; i < port_count; i++) {
+        IdString name = r.read_id();
+        auto &port = ports[name];
+        port.name = name;
+        port.type = PortType(r.read_u8());
+        port.net = r.read_net();
+    }
+    uint32_t port_cell_count = r.read_u32();
+    for (uint32_t i = 0; i < port_cell_count; i++) {
+        IdString name = r.read_id();
+        port_cells[name] = r.read_cell();
+    }
+
+    uint32_t hier_count = r.read_u32();
+    for (uint32_t i = 0; i < hier_count; i++) {
+        IdString path = r.read_id();
+        HierarchicalCell hc;
+        hc.name = r.read_id();
+        hc.type = r.read_id();
+        hc.parent = r.read_id();
+        hc.fullpath = r.read_id();
+        r.read_id_map(hc.leaf_cells);
+        r.read_id_map(hc.nets);
+        r.read_id_map(hc.leaf_cells_by_gname);
+        r.read_id_map(hc.nets_by_gname);
+        uint32_t hier_port_count = r.read_u32();
+        for (uint32_t j = 0; j < hier_port_count; j++) {
+            IdString key = r.read_id();
+            HierarchicalPort port;
+            port.name = r.read_id();
+            port.dir = PortType(r.read_u8());
+            port.nets = r.read_ids();
+            port.offset = int32_t(r.read_u32());
+            port.upto = r.read_u8();
+            hc.ports[key] = std::move(port);
+        }
+        r.read_id_map(hc.hier_cells);
+        hierarchy[path] = std::move(hc);
+    }
+
+    // Arch-specific cell data may be needed to bind cells, so is rebuilt first
+    assignArchInfo();
+    for (size_t i = 0; i < placement.size(); i++)
+        bindBel(placement.at(i).second, placement.at(i).first, placement_strength.at(i));
+    for (NetInfo *ni : net_order) {
+        uint32_t wire_count = r.read_u32();
+        for (uint32_t j = 0; j < wire_count; j++) {
+            WireId wire = r.read_wire();
+            PipId pip = r.read_pip();
+            PlaceStrength strength = PlaceStrength(r.read_u8());
+            if (pip == PipId())
+                bindWire(wire, ni, strength);
+            else
+                bindPip(pip, ni, strength);
+        }
+    }
+    if (r.pos != r.size)
+        log_error("Design snapshot has unexpected data at the end.\n");
+}
+
+void Context::writeSnapshot(const std::string &filename) const
+{
+    std::vector<uint8_t> data = saveSnapshot();
+    std::ofstream f(filename, std::ios::binary);
+    if (!f)
+        log_error("Failed to open design snapshot '%s' for writing.\n", filename.c_str());
+    f.write(reinterpret_cast<const char *>(data.data()), data.size());
+    if (!f)
+        log_error("Failed to write design snapshot '%s'.\n", filename.c_str());
+}
+
+void Context::loadSnapshot(const std::string &filename)
+{
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (std::exception &e) {
+        log_error("Failed to open design snapshot '%s': %s\n", filename.c_str(), e.what());
+    }
+    restoreSnapshot(reinterpret_cast<const uint8_t *>(file.data()), file.size());
+}
+
+void Context::checkpoint() { checkpoint_data = saveSnapshot(); }
+
+void Context::rollback()
+{
+    if (checkpoint_data.empty())
+        log_error("No checkpoint to roll back to.\n");
+    restoreSnapshot(checkpoint_data.data(), checkpoint_data.size());
+}
+
+NEXTPNR_NAMESPACE_END
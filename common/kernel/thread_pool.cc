@@ -0,0 +1,128 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+NEXTPNR_NAMESPACE_BEGIN
+
+#if !defined(NPNR_DISABLE_THREADS)
+
+ThreadPool::ThreadPool(int threads) : num_threads(std::max(threads, 1))
+{
+    workers.reserve(num_threads - 1);
+    for (int i = 1; i < num_threads; i++)
+        workers.emplace_back([this]() { worker(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        shutdown = true;
+    }
+    start_cv.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+void ThreadPool::do_work()
+{
+    while (true) {
+        int i = next_index.fetch_add(1);
+        if (i >= job_count)
+            break;
+        try {
+            (*job)(i);
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (!job_error)
+                job_error = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::worker()
+{
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            start_cv.wait(lock, [&]() { return shutdown || generation != seen_generation; });
+            if (shutdown)
+                return;
+            seen_generation = generation;
+        }
+        do_work();
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (--busy_workers == 0)
+                done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run(int count, const std::function<void(int)> &func)
+{
+    if (count <= 0)
+        return;
+    if (workers.empty() || count == 1 || running.exchange(true)) {
+        for (int i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        job = &func;
+        job_count = count;
+        next_index = 0;
+        job_error = nullptr;
+        busy_workers = int(workers.size());
+        ++generation;
+    }
+    start_cv.notify_all();
+    do_work();
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [&]() { return busy_workers == 0; });
+        job = nullptr;
+        std::swap(error, job_error);
+    }
+    running = false;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+#else /* !defined(NPNR_DISABLE_THREADS) */
+
+ThreadPool::ThreadPool(int threads) : num_threads(1) {}
+
+ThreadPool::~ThreadPool() {}
+
+void ThreadPool::run(int count, const std::function<void(int)> &func)
+{
+    for (int i = 0; i < count; i++)
+        func(i);
+}
+
+#endif
+
+NEXTPNR_NAMESPACE_END
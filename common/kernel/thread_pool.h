@@ -0,0 +1,88 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if !defined(NPNR_DISABLE_THREADS)
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// A fixed set of worker threads that persist between parallel sections, so passes that fan work out many times (for
+// example once per iteration) don't pay for creating and joining threads each time.
+//
+// The thread calling run() also takes part in the work, so a pool constructed for N threads starts N-1 workers.
+// With NPNR_DISABLE_THREADS, everything runs on the calling thread.
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    // Total number of threads taking part in run(), including the caller
+    int size() const { return num_threads; }
+
+    // Call func(i) for every i in [0, count) across the pool, returning once all calls are complete. Indices are
+    // handed out dynamically, so func must not assume a particular index runs on a particular thread. If any call
+    // throws, the first exception is rethrown here after the others have finished.
+    //
+    // A pool may be shared between passes. If it is already running a job, for example when run() is called from inside
+    // one, the calls are all made on the calling thread instead.
+    void run(int count, const std::function<void(int)> &func);
+
+  private:
+    int num_threads;
+#if !defined(NPNR_DISABLE_THREADS)
+    void worker();
+    void do_work();
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable start_cv, done_cv;
+    // Incremented for every run() so workers can tell a new job from a spurious wakeup
+    uint64_t generation = 0;
+    bool shutdown = false;
+    int busy_workers = 0;
+
+    // Set while a job is running, so a nested or concurrent run() falls back to the calling thread
+    std::atomic<bool> running{false};
+    const std::function<void(int)> *job = nullptr;
+    int job_count = 0;
+    std::atomic<int> next_index{0};
+    std::exception_ptr job_error;
+#endif
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* THREAD_POOL_H */
@@ -24,8 +24,10 @@
 #include <boost/range/adaptor/reversed.hpp>
 #include <deque>
 #include <map>
+#include <queue>
 #include <utility>
 #include "log.h"
+#include "profiler.h"
 #include "util.h"
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -40,24 +42,36 @@ TimingAnalyser::TimingAnalyser(Context *ctx) : ctx(ctx)
 
 void TimingAnalyser::setup(bool update_net_timings, bool update_histogram, bool update_crit_paths)
 {
+    NPNR_PROFILE_ZONE("sta_setup");
+    setup_corners();
     init_ports();
+    port_timing.assign(ports.size(), PortTiming());
     get_cell_delays();
+    build_graph();
     topo_sort();
     setup_port_domains();
+    setup_seeds();
     identify_related_domains();
+    std::vector<PortTiming>().swap(port_timing);
     run(true, update_net_timings, update_histogram, update_crit_paths);
 }
 
 void TimingAnalyser::run(bool update_route_delays, bool update_net_timings, bool update_histogram,
                          bool update_crit_paths)
 {
+    NPNR_PROFILE_ZONE("sta_run");
     reset_times();
     if (update_route_delays)
         get_route_delays();
+    // Corner times are only needed for reports, so aren't propagated otherwise
+    corner_arrival.clear();
+    if (update_crit_paths && !corners.empty())
+        corner_arrival.assign(arrival.size() * corners.size(), init_delay);
     walk_forward();
     walk_backward();
     compute_slack();
     compute_criticality();
+    clear_dirty();
 
     // Ensure we clear all timing results if any of them has been marked as
     // as to be updated. This is done so we ensure it's not possible to have
@@ -76,45 +90,125 @@ void TimingAnalyser::run(bool update_route_delays, bool update_net_timings, bool
 
     if (update_crit_paths) {
         build_crit_path_reports();
+        build_corner_reports();
+        build_cdc_report();
+    }
+}
+
+void TimingAnalyser::setup_corners()
+{
+    // Corners are given as a comma separated list of name:logic_derate[:routing_derate]
+    corners.clear();
+    auto setting = ctx->settings.find(ctx->id("timing/corners"));
+    if (setting == ctx->settings.end())
+        return;
+    std::string corner_list = setting->second.as_string();
+    size_t pos = 0;
+    while (pos < corner_list.size()) {
+        size_t end = corner_list.find(',', pos);
+        if (end == std::string::npos)
+            end = corner_list.size();
+        std::string corner = corner_list.substr(pos, end - pos);
+        pos = end + 1;
+        std::vector<std::string> fields;
+        size_t field_pos = 0;
+        while (true) {
+            size_t field_end = corner.find(':', field_pos);
+            fields.push_back(corner.substr(field_pos, field_end - field_pos));
+            if (field_end == std::string::npos)
+                break;
+            field_pos = field_end + 1;
+        }
+        if (fields.size() < 2 || fields.size() > 3 || fields.at(0).empty())
+            log_error("Invalid timing corner '%s', expected name:logic_derate[:routing_derate].\n", corner.c_str());
+        TimingCorner tc;
+        tc.name = ctx->id(fields.at(0));
+        try {
+            tc.logic_derate = std::stof(fields.at(1));
+            tc.routing_derate = (fields.size() == 3) ? std::stof(fields.at(2)) : tc.logic_derate;
+        } catch (std::exception &) {
+            log_error("Invalid derating factor in timing corner '%s'.\n", corner.c_str());
+        }
+        if (tc.logic_derate <= 0 || tc.routing_derate <= 0)
+            log_error("Derating factors of timing corner '%s' must be positive.\n", corner.c_str());
+        corners.push_back(tc);
     }
 }
 
 void TimingAnalyser::init_ports()
 {
     // Per cell port structures
+    port_index.clear();
+    ports.clear();
     for (auto &cell : ctx->cells) {
         CellInfo *ci = cell.second.get();
         for (auto &port : ci->ports) {
-            auto &data = ports[CellPortKey(ci->name, port.first)];
+            CellPortKey key(ci->name, port.first);
+            port_index.emplace(key, int(ports.size()));
+            ports.emplace_back();
+            auto &data = ports.back();
             data.type = port.second.type;
-            data.cell_port = CellPortKey(ci->name, port.first);
+            data.cell_port = key;
+            data.cell = ci;
         }
     }
 }
 
+const TimingAnalyser::PortTiming &TimingAnalyser::get_port_timing(const CellInfo *ci, IdString port)
+{
+    auto &data = port_timing.at(port_index.at(CellPortKey(ci->name, port)));
+    if (data.queried)
+        return data;
+    data.queried = true;
+    auto &pi = ci->ports.at(port);
+    int clkInfoCount = 0;
+    data.port_class = ctx->getPortTimingClass(ci, port, clkInfoCount);
+    if (data.port_class == TMG_CLOCK_INPUT || data.port_class == TMG_GEN_CLOCK || data.port_class == TMG_IGNORE)
+        return data;
+    // Only the clocking info and arcs of input and output ports are used
+    if (pi.type == PORT_INOUT)
+        return data;
+    if ((pi.type == PORT_IN && data.port_class == TMG_REGISTER_INPUT) ||
+        (pi.type == PORT_OUT && data.port_class == TMG_REGISTER_OUTPUT)) {
+        for (int i = 0; i < clkInfoCount; i++)
+            data.clocking.push_back(ctx->getPortClockingInfo(ci, port, i));
+    }
+    for (auto &other_port : ci->ports) {
+        auto &op = other_port.second;
+        // ignore dangling ports, and ports in the same direction
+        if (op.net == nullptr || (pi.type == PORT_IN && op.type != PORT_OUT) ||
+            (pi.type == PORT_OUT && op.type != PORT_IN))
+            continue;
+        DelayQuad delay;
+        bool is_path = (pi.type == PORT_IN) ? ctx->getCellDelay(ci, port, other_port.first, delay)
+                                            : ctx->getCellDelay(ci, other_port.first, port, delay);
+        if (is_path)
+            data.comb_arcs.emplace_back(other_port.first, delay);
+    }
+    return data;
+}
+
 void TimingAnalyser::get_cell_delays()
 {
     auto async_clk_key = domains.at(async_clock_id);
 
-    for (auto &port : ports) {
-        CellInfo *ci = cell_info(port.first);
-        auto &pi = port_info(port.first);
-        auto &pd = port.second;
+    for (auto &pd : ports) {
+        CellInfo *ci = pd.cell;
+        auto &pi = ci->ports.at(pd.cell_port.port);
 
-        IdString name = port.first.port;
+        IdString name = pd.cell_port.port;
         // Ignore dangling ports altogether for timing purposes
         if (!pi.net)
             continue;
         pd.cell_arcs.clear();
-        int clkInfoCount = 0;
-        TimingPortClass cls = ctx->getPortTimingClass(ci, name, clkInfoCount);
+        auto &timing = get_port_timing(ci, name);
+        TimingPortClass cls = timing.port_class;
         if (cls == TMG_CLOCK_INPUT || cls == TMG_GEN_CLOCK || cls == TMG_IGNORE)
             continue;
         if (pi.type == PORT_IN) {
             // Input ports might have setup/hold relationships
             if (cls == TMG_REGISTER_INPUT) {
-                for (int i = 0; i < clkInfoCount; i++) {
-                    auto info = ctx->getPortClockingInfo(ci, name, i);
+                for (auto &info : timing.clocking) {
                     if (!ci->ports.count(info.clock_port) || ci->ports.at(info.clock_port).net == nullptr)
                         continue;
                     pd.cell_arcs.emplace_back(CellArc::SETUP, info.clock_port, DelayQuad(info.setup, info.setup),
@@ -127,22 +221,10 @@ void TimingAnalyser::get_cell_delays()
             else if (cls == TMG_ENDPOINT) {
                 pd.cell_arcs.emplace_back(CellArc::ENDPOINT, async_clk_key.key.clock, DelayQuad{});
             }
-            // Combinational delays through cell
-            for (auto &other_port : ci->ports) {
-                auto &op = other_port.second;
-                // ignore dangling ports and non-outputs
-                if (op.net == nullptr || op.type != PORT_OUT)
-                    continue;
-                DelayQuad delay;
-                bool is_path = ctx->getCellDelay(ci, name, other_port.first, delay);
-                if (is_path)
-                    pd.cell_arcs.emplace_back(CellArc::COMBINATIONAL, other_port.first, delay);
-            }
         } else if (pi.type == PORT_OUT) {
             // Output ports might have clk-to-q relationships
             if (cls == TMG_REGISTER_OUTPUT) {
-                for (int i = 0; i < clkInfoCount; i++) {
-                    auto info = ctx->getPortClockingInfo(ci, name, i);
+                for (auto &info : timing.clocking) {
                     if (!ci->ports.count(info.clock_port) || ci->ports.at(info.clock_port).net == nullptr)
                         continue;
                     pd.cell_arcs.emplace_back(CellArc::CLK_TO_Q, info.clock_port, info.clockToQ, info.edge);
@@ -152,81 +234,178 @@ void TimingAnalyser::get_cell_delays()
             else if (cls == TMG_STARTPOINT) {
                 pd.cell_arcs.emplace_back(CellArc::STARTPOINT, async_clk_key.key.clock, DelayQuad{});
             }
-            // Combinational delays through cell
-            for (auto &other_port : ci->ports) {
-                auto &op = other_port.second;
-                // ignore dangling ports and non-inputs
-                if (op.net == nullptr || op.type != PORT_IN)
-                    continue;
-                DelayQuad delay;
-                bool is_path = ctx->getCellDelay(ci, other_port.first, name, delay);
-                if (is_path)
-                    pd.cell_arcs.emplace_back(CellArc::COMBINATIONAL, other_port.first, delay);
-            }
-        }
-    }
-}
-
-void TimingAnalyser::get_route_delays()
-{
-    for (auto &net : ctx->nets) {
-        NetInfo *ni = net.second.get();
-        if (ni->driver.cell == nullptr || ni->driver.cell->bel == BelId())
-            continue;
-        for (auto &usr : ni->users) {
-            if (usr.cell->bel == BelId())
-                continue;
-            ports.at(CellPortKey(usr)).route_delay = DelayPair(ctx->getNetinfoRouteDelay(ni, usr));
         }
+        // Combinational delays through cell
+        if (pi.type == PORT_IN || pi.type == PORT_OUT)
+            for (auto &arc : timing.comb_arcs)
+                pd.cell_arcs.emplace_back(CellArc::COMBINATIONAL, arc.first, arc.second);
     }
 }
 
-void TimingAnalyser::set_route_delay(CellPortKey port, DelayPair value) { ports.at(port).route_delay = value; }
-
-void TimingAnalyser::topo_sort()
+void TimingAnalyser::build_graph()
 {
-    TopoSort<CellPortKey> topo;
-    for (auto &port : ports) {
-        auto &pd = port.second;
-        // All ports are nodes
-        topo.node(port.first);
+    // Compile the netlist and cell arcs into a CSR graph over port indices, so that the walks never need to go
+    // through the netlist hashmaps
+    int n = int(ports.size());
+    edges.clear();
+    fanout_begin.assign(n + 1, 0);
+    for (int p = 0; p < n; p++) {
+        auto &pd = ports.at(p);
+        fanout_begin.at(p) = int(edges.size());
         if (pd.type == PORT_IN) {
             // inputs: combinational arcs through the cell are edges
             for (auto &arc : pd.cell_arcs) {
                 if (arc.type != CellArc::COMBINATIONAL)
                     continue;
-                topo.edge(port.first, CellPortKey(port.first.cell, arc.other_port));
+                edges.push_back(TimingEdge{p, port_index.at(CellPortKey(pd.cell_port.cell, arc.other_port)), false,
+                                           arc.value.delayPair()});
             }
         } else if (pd.type == PORT_OUT) {
             // output: routing arcs are edges
-            const NetInfo *pn = port_info(port.first).net;
+            const NetInfo *pn = pd.cell->ports.at(pd.cell_port.port).net;
             if (pn != nullptr) {
                 for (auto &usr : pn->users)
-                    topo.edge(port.first, CellPortKey(usr));
+                    edges.push_back(TimingEdge{p, port_index.at(CellPortKey(usr)), true, DelayPair(0)});
             }
         }
     }
+    fanout_begin.at(n) = int(edges.size());
+    // Fanin lists by counting sort on the sink port
+    fanin_begin.assign(n + 1, 0);
+    for (auto &e : edges)
+        ++fanin_begin.at(e.to + 1);
+    for (int p = 0; p < n; p++)
+        fanin_begin.at(p + 1) += fanin_begin.at(p);
+    fanin_edges.resize(edges.size());
+    std::vector<int> cursor(fanin_begin.begin(), fanin_begin.end() - 1);
+    for (int i = 0; i < int(edges.size()); i++)
+        fanin_edges.at(cursor.at(edges.at(i).to)++) = i;
+}
 
+void TimingAnalyser::get_route_delays()
+{
+    for (auto &pd : ports) {
+        auto &pi = pd.cell->ports.at(pd.cell_port.port);
+        NetInfo *ni = pi.net;
+        // only net users have a route delay
+        if (ni == nullptr || !pi.user_idx || ni->driver.cell == nullptr || ni->driver.cell->bel == BelId() ||
+            pd.cell->bel == BelId())
+            continue;
+        pd.route_delay = DelayPair(ctx->getNetinfoRouteDelay(ni, ni->users.at(pi.user_idx)));
+    }
+}
+
+void TimingAnalyser::set_route_delay(CellPortKey port, DelayPair value)
+{
+    int p = port_index.at(port);
+    auto &pd = ports.at(p);
+    if (pd.route_delay.min_delay == value.min_delay && pd.route_delay.max_delay == value.max_delay)
+        return;
+    pd.route_delay = value;
+    if (!pd.dirty) {
+        pd.dirty = true;
+        dirty_ports.push_back(p);
+    }
+}
+
+void TimingAnalyser::update_net_delays(const NetInfo *net)
+{
+    if (net->driver.cell == nullptr || net->driver.cell->bel == BelId())
+        return;
+    for (auto &usr : net->users) {
+        if (usr.cell->bel == BelId())
+            continue;
+        set_route_delay(CellPortKey(usr), DelayPair(ctx->getNetinfoRouteDelay(net, usr)));
+    }
+}
+
+void TimingAnalyser::clear_dirty()
+{
+    for (int p : dirty_ports)
+        ports.at(p).dirty = false;
+    dirty_ports.clear();
+}
+
+void TimingAnalyser::topo_sort()
+{
+    int n = int(ports.size());
+    // Kahn's algorithm, assigning each port the length of the longest path from a source as its level
+    std::vector<int> level(n, 0), pending(n);
+    std::vector<int> queue;
+    queue.reserve(n);
+    for (int p = 0; p < n; p++) {
+        pending.at(p) = fanin_begin.at(p + 1) - fanin_begin.at(p);
+        if (pending.at(p) == 0)
+            queue.push_back(p);
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        int p = queue.at(i);
+        for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++) {
+            int to = edges.at(e).to;
+            level.at(to) = std::max(level.at(to), level.at(p) + 1);
+            if (--pending.at(to) == 0)
+                queue.push_back(to);
+        }
+    }
     bool ignore_loops = bool_or_default(ctx->settings, ctx->id("timing/ignoreLoops"), false);
-    bool no_loops = topo.sort();
-    if (!no_loops && !ignore_loops) {
-        log_info("Found %d combinational loops:\n", int(topo.loops.size()));
-        int i = 0;
-        for (auto &loop : topo.loops) {
-            log_info("    loop %d:\n", ++i);
-            for (auto &port : loop) {
-                log_info("        %s.%s (%s)\n", ctx->nameOf(port.cell), ctx->nameOf(port.port),
-                         ctx->nameOf(port_info(port).net));
+    bool no_loops = (int(queue.size()) == n);
+
+    if (!no_loops) {
+        // Fall back to a DFS based sort that can identify loops, and find the levels ignoring loop-closing edges
+        TopoSort<int> topo;
+        for (int p = 0; p < n; p++) {
+            topo.node(p);
+            for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++)
+                topo.edge(p, edges.at(e).to);
+        }
+        topo.sort();
+
+        if (!ignore_loops) {
+            log_info("Found %d combinational loops:\n", int(topo.loops.size()));
+            int i = 0;
+            for (auto &loop : topo.loops) {
+                log_info("    loop %d:\n", ++i);
+                for (int p : loop) {
+                    auto &port = ports.at(p).cell_port;
+                    log_info("        %s.%s (%s)\n", ctx->nameOf(port.cell), ctx->nameOf(port.port),
+                             ctx->nameOf(port_info(port).net));
+                }
             }
+
+            if (ctx->force)
+                log_warning("Timing analysis failed due to combinational loops.\n");
+            else
+                log_error("Timing analysis failed due to combinational loops.\n");
         }
 
-        if (ctx->force)
-            log_warning("Timing analysis failed due to combinational loops.\n");
-        else
-            log_error("Timing analysis failed due to combinational loops.\n");
+        std::vector<int> order_pos(n);
+        for (int i = 0; i < n; i++)
+            order_pos.at(topo.sorted.at(i)) = i;
+        std::fill(level.begin(), level.end(), 0);
+        for (int p : topo.sorted) {
+            for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++) {
+                int to = edges.at(e).to;
+                if (order_pos.at(to) > order_pos.at(p))
+                    level.at(to) = std::max(level.at(to), level.at(p) + 1);
+            }
+        }
     }
     have_loops = !no_loops;
-    std::swap(topological_order, topo.sorted);
+
+    // Bucket ports by level
+    int num_levels = 0;
+    for (int p = 0; p < n; p++)
+        num_levels = std::max(num_levels, level.at(p) + 1);
+    level_begin.assign(num_levels + 1, 0);
+    for (int p = 0; p < n; p++)
+        ++level_begin.at(level.at(p) + 1);
+    for (int l = 0; l < num_levels; l++)
+        level_begin.at(l + 1) += level_begin.at(l);
+    topological_order.resize(n);
+    std::vector<int> cursor(level_begin.begin(), level_begin.end() - 1);
+    for (int p = 0; p < n; p++)
+        topological_order.at(cursor.at(level.at(p))++) = p;
+    std::swap(port_level, level);
 }
 
 void TimingAnalyser::setup_port_domains()
@@ -235,86 +414,106 @@ void TimingAnalyser::setup_port_domains()
         d.startpoints.clear();
         d.endpoints.clear();
     }
+    int n = int(ports.size());
+    // Domains are first gathered into per-port lists, then flattened once a fixed point is reached
+    std::vector<std::vector<domain_id_t>> arr_doms(n), req_doms(n);
+    auto add_domain = [&](std::vector<domain_id_t> &doms, domain_id_t dom) {
+        if (std::find(doms.begin(), doms.end(), dom) != doms.end())
+            return;
+        doms.push_back(dom);
+        updated_domains = true;
+    };
+    auto copy_domains = [&](std::vector<std::vector<domain_id_t>> &doms, int from, int to) {
+        if (from == to)
+            return;
+        for (auto dom : doms.at(from))
+            add_domain(doms.at(to), dom);
+    };
     bool first_iter = true;
     do {
         // Go forward through the topological order (domains from the PoV of arrival time)
         updated_domains = false;
-        for (auto port : topological_order) {
-            auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
-                if (first_iter) {
-                    for (auto &fanin : pd.cell_arcs) {
-                        domain_id_t dom;
-                        // registered outputs are startpoints
-                        if (fanin.type == CellArc::CLK_TO_Q)
-                            dom = domain_id(port.cell, fanin.other_port, fanin.edge);
-                        else if (fanin.type == CellArc::STARTPOINT)
-                            dom = async_clock_id;
-                        else
-                            continue;
-                        // create per-domain data
-                        pd.arrival[dom];
-                        domains.at(dom).startpoints.emplace_back(port, fanin.other_port);
-                    }
-                }
-                // copy domains across routing
-                if (pi.net != nullptr)
-                    for (auto &usr : pi.net->users)
-                        copy_domains(port, CellPortKey(usr), false);
-            } else {
-                // copy domains from input to output
-                for (auto &fanout : pd.cell_arcs) {
-                    if (fanout.type != CellArc::COMBINATIONAL)
+        for (int p : topological_order) {
+            auto &pd = ports.at(p);
+            if (first_iter && pd.type == PORT_OUT) {
+                for (auto &fanin : pd.cell_arcs) {
+                    domain_id_t dom;
+                    // registered outputs are startpoints
+                    if (fanin.type == CellArc::CLK_TO_Q)
+                        dom = domain_id(pd.cell_port.cell, fanin.other_port, fanin.edge);
+                    else if (fanin.type == CellArc::STARTPOINT)
+                        dom = async_clock_id;
+                    else
                         continue;
-                    copy_domains(port, CellPortKey(port.cell, fanout.other_port), false);
+                    // create per-domain data
+                    add_domain(arr_doms.at(p), dom);
+                    domains.at(dom).startpoints.emplace_back(p, fanin.other_port);
                 }
             }
+            // copy domains across routing (outputs) and from input to output (inputs)
+            for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++)
+                copy_domains(arr_doms, p, edges.at(e).to);
         }
         // Go backward through the topological order (domains from the PoV of required time)
-        for (auto port : reversed_range(topological_order)) {
-            auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
-                // copy domains from output to input
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type != CellArc::COMBINATIONAL)
+        for (int p : reversed_range(topological_order)) {
+            auto &pd = ports.at(p);
+            if (first_iter && pd.type == PORT_IN) {
+                for (auto &fanout : pd.cell_arcs) {
+                    domain_id_t dom;
+                    // registered inputs are endpoints
+                    if (fanout.type == CellArc::SETUP)
+                        dom = domain_id(pd.cell_port.cell, fanout.other_port, fanout.edge);
+                    else if (fanout.type == CellArc::ENDPOINT)
+                        dom = async_clock_id;
+                    else
                         continue;
-                    copy_domains(port, CellPortKey(port.cell, fanin.other_port), true);
-                }
-            } else {
-                if (first_iter) {
-                    for (auto &fanout : pd.cell_arcs) {
-                        domain_id_t dom;
-                        // registered inputs are endpoints
-                        if (fanout.type == CellArc::SETUP)
-                            dom = domain_id(port.cell, fanout.other_port, fanout.edge);
-                        else if (fanout.type == CellArc::ENDPOINT)
-                            dom = async_clock_id;
-                        else
-                            continue;
-                        // create per-domain data
-                        pd.required[dom];
-                        domains.at(dom).endpoints.emplace_back(port, fanout.other_port);
-                    }
+                    // create per-domain data
+                    add_domain(req_doms.at(p), dom);
+                    domains.at(dom).endpoints.emplace_back(p, fanout.other_port);
                 }
-                // copy port to driver
-                if (pi.net != nullptr && pi.net->driver.cell != nullptr)
-                    copy_domains(port, CellPortKey(pi.net->driver), true);
             }
-        }
-        // Iterate over ports and find domain pairs
-        for (auto port : topological_order) {
-            auto &pd = ports.at(port);
-            for (auto &arr : pd.arrival)
-                for (auto &req : pd.required) {
-                    pd.domain_pairs[domain_pair_id(arr.first, req.first)];
-                }
+            // copy domains from output to input (outputs) and from port to driver (inputs)
+            for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++)
+                copy_domains(req_doms, p, edges.at(fanin_edges.at(i)).from);
         }
         first_iter = false;
         // If there are loops, repeat the process until a fixed point is reached, as there might be unusual ways to
         // visit points, which would result in a missing domain key and therefore crash later on
     } while (have_loops && updated_domains);
+
+    // Flatten the per-port domains and find domain pairs
+    arrival.clear();
+    required.clear();
+    port_pairs.clear();
+    for (int p = 0; p < n; p++) {
+        auto &pd = ports.at(p);
+        auto &ad = arr_doms.at(p), &rd = req_doms.at(p);
+        std::sort(ad.begin(), ad.end());
+        std::sort(rd.begin(), rd.end());
+        pd.arrival_begin = int(arrival.size());
+        for (auto dom : ad) {
+            arrival.emplace_back();
+            arrival.back().domain = dom;
+        }
+        pd.arrival_end = int(arrival.size());
+        pd.required_begin = int(required.size());
+        for (auto dom : rd) {
+            required.emplace_back();
+            required.back().domain = dom;
+        }
+        pd.required_end = int(required.size());
+        pd.pairs_begin = int(port_pairs.size());
+        for (int a = pd.arrival_begin; a < pd.arrival_end; a++)
+            for (int r = pd.required_begin; r < pd.required_end; r++) {
+                port_pairs.emplace_back();
+                auto &pdp = port_pairs.back();
+                pdp.pair = domain_pair_id(arrival.at(a).domain, required.at(r).domain);
+                pdp.arrival = a;
+                pdp.required = r;
+            }
+        pd.pairs_end = int(port_pairs.size());
+    }
+
     for (auto &dp : domain_pairs) {
         auto &launch_data = domains.at(dp.key.launch);
         auto &capture_data = domains.at(dp.key.capture);
@@ -334,6 +533,68 @@ void TimingAnalyser::setup_port_domains()
     }
 }
 
+void TimingAnalyser::setup_seeds()
+{
+    // Flatten the startpoints and endpoints of each domain into per-port lists of initial times, so a port's times can
+    // be computed on their own during an incremental update
+    int n = int(ports.size());
+    std::vector<int> count(n + 1, 0);
+    for (auto &dom : domains) {
+        for (auto &sp : dom.startpoints)
+            ++count.at(sp.first + 1);
+        for (auto &ep : dom.endpoints)
+            ++count.at(ep.first + 1);
+    }
+    for (int p = 0; p < n; p++)
+        count.at(p + 1) += count.at(p);
+    for (int p = 0; p < n; p++) {
+        ports.at(p).seeds_begin = count.at(p);
+        ports.at(p).seeds_end = count.at(p);
+    }
+    seeds.resize(count.at(n));
+    for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
+        auto &dom = domains.at(dom_id);
+        for (auto &sp : dom.startpoints) {
+            auto &pd = ports.at(sp.first);
+            auto &seed = seeds.at(pd.seeds_end++);
+            seed.domain = dom_id;
+            seed.value = DelayPair(0);
+            seed.clock_port = -1;
+            // TODO: clock routing delay, if analysis of that is enabled
+            if (sp.second != IdString()) {
+                // clocked startpoints have a clock-to-out time
+                for (auto &fanin : pd.cell_arcs) {
+                    if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == sp.second) {
+                        seed.value = seed.value + fanin.value.delayPair();
+                        break;
+                    }
+                }
+                seed.clock_port = port_index.at(CellPortKey(pd.cell_port.cell, sp.second));
+            }
+        }
+        // Note that clock frequency will be considered later in the analysis for, for now all required times are
+        // normalised to 0ns
+        for (auto &ep : dom.endpoints) {
+            auto &pd = ports.at(ep.first);
+            auto &seed = seeds.at(pd.seeds_end++);
+            seed.domain = dom_id;
+            seed.value = DelayPair(0);
+            seed.clock_port = -1;
+            // TODO: clock routing delay, if analysis of that is enabled
+            if (ep.second != IdString()) {
+                // Add setup/hold time, if this endpoint is clocked
+                for (auto &fanin : pd.cell_arcs) {
+                    if (fanin.type == CellArc::SETUP && fanin.other_port == ep.second)
+                        seed.value.min_delay -= fanin.value.maxDelay();
+                    if (fanin.type == CellArc::HOLD && fanin.other_port == ep.second)
+                        seed.value.max_delay -= fanin.value.maxDelay();
+                }
+                seed.clock_port = port_index.at(CellPortKey(pd.cell_port.cell, ep.second));
+            }
+        }
+    }
+}
+
 void TimingAnalyser::identify_related_domains()
 {
 
@@ -372,11 +633,10 @@ void TimingAnalyser::identify_related_domains()
                 }
 
                 // Get the driver timing class
-                int info_count = 0;
-                auto timing_class = ctx->getPortTimingClass(cell, port, info_count);
+                auto &driver_timing = get_port_timing(cell, port);
 
                 // The driver must be a combinational output
-                if (timing_class != TMG_COMB_OUTPUT) {
+                if (driver_timing.port_class != TMG_COMB_OUTPUT) {
                     drivers[ni->name] = delay_acc;
                     return;
                 }
@@ -395,13 +655,24 @@ void TimingAnalyser::identify_related_domains()
                     }
 
                     // The input must be a combinational input
-                    timing_class = ctx->getPortTimingClass(cell, pi.name, info_count);
-                    if (timing_class != TMG_COMB_INPUT) {
+                    if (get_port_timing(cell, pi.name).port_class != TMG_COMB_INPUT) {
                         continue;
                     }
-                    // There must be a combinational arc
+                    // There must be a combinational arc. get_port_timing() doesn't fetch the arcs of inout ports, so
+                    // ask the Arch for those
                     DelayQuad delay;
-                    if (!ctx->getCellDelay(cell, pi.name, port, delay)) {
+                    bool is_path = false;
+                    if (cell->ports.at(port).type == PORT_INOUT) {
+                        is_path = ctx->getCellDelay(cell, pi.name, port, delay);
+                    } else {
+                        for (auto &arc : driver_timing.comb_arcs) {
+                            if (arc.first == pi.name) {
+                                delay = arc.second;
+                                is_path = true;
+                            }
+                        }
+                    }
+                    if (!is_path) {
                         continue;
                     }
 
@@ -502,239 +773,457 @@ void TimingAnalyser::identify_related_domains()
 
 void TimingAnalyser::reset_times()
 {
-    for (auto &port : ports) {
-        auto do_reset = [&](dict<domain_id_t, ArrivReqTime> &times) {
-            for (auto &t : times) {
-                t.second.value = init_delay;
-                t.second.path_length = 0;
-                t.second.bwd_min = CellPortKey();
-                t.second.bwd_max = CellPortKey();
-            }
-        };
-        do_reset(port.second.arrival);
-        do_reset(port.second.required);
-        for (auto &dp : port.second.domain_pairs) {
-            dp.second.setup_slack = std::numeric_limits<delay_t>::max();
-            dp.second.hold_slack = std::numeric_limits<delay_t>::max();
-            dp.second.max_path_length = 0;
-            dp.second.criticality = 0;
+    auto do_reset = [&](std::vector<ArrivReqTime> &times) {
+        for (auto &t : times) {
+            t.value = init_delay;
+            t.path_length = 0;
+            t.bwd_min = -1;
+            t.bwd_max = -1;
         }
-        port.second.worst_crit = 0;
-        port.second.worst_setup_slack = std::numeric_limits<delay_t>::max();
-        port.second.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    };
+    do_reset(arrival);
+    do_reset(required);
+    for (auto &pdp : port_pairs) {
+        pdp.setup_slack = std::numeric_limits<delay_t>::max();
+        pdp.hold_slack = std::numeric_limits<delay_t>::max();
+        pdp.max_path_length = 0;
+        pdp.criticality = 0;
+    }
+    for (auto &pd : ports) {
+        pd.worst_crit = 0;
+        pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+        pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
     }
 }
 
-void TimingAnalyser::set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                                      CellPortKey prev)
+void TimingAnalyser::set_arrival_time(int target, domain_id_t domain, DelayPair value, int path_length, int prev)
 {
-    auto &arr = ports.at(target).arrival.at(domain);
-    if (arrival.max_delay > arr.value.max_delay) {
-        arr.value.max_delay = arrival.max_delay;
+    auto &pd = ports.at(target);
+    auto &arr = *find_time(arrival, pd.arrival_begin, pd.arrival_end, domain);
+    if (value.max_delay > arr.value.max_delay) {
+        arr.value.max_delay = value.max_delay;
         arr.bwd_max = prev;
     }
-    if (!setup_only && (arrival.min_delay < arr.value.min_delay)) {
-        arr.value.min_delay = arrival.min_delay;
+    if (!setup_only && (value.min_delay < arr.value.min_delay)) {
+        arr.value.min_delay = value.min_delay;
         arr.bwd_min = prev;
     }
     arr.path_length = std::max(arr.path_length, path_length);
 }
 
-void TimingAnalyser::set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                                       CellPortKey prev)
+void TimingAnalyser::set_required_time(int target, domain_id_t domain, DelayPair value, int path_length, int prev)
 {
-    auto &req = ports.at(target).required.at(domain);
-    if (required.min_delay < req.value.min_delay) {
-        req.value.min_delay = required.min_delay;
+    auto &pd = ports.at(target);
+    auto &req = *find_time(required, pd.required_begin, pd.required_end, domain);
+    if (value.min_delay < req.value.min_delay) {
+        req.value.min_delay = value.min_delay;
         req.bwd_min = prev;
     }
-    if (!setup_only && (required.max_delay > req.value.max_delay)) {
-        req.value.max_delay = required.max_delay;
+    if (!setup_only && (value.max_delay > req.value.max_delay)) {
+        req.value.max_delay = value.max_delay;
         req.bwd_max = prev;
     }
     req.path_length = std::max(req.path_length, path_length);
 }
 
-void TimingAnalyser::walk_forward()
+template <typename TFunc> void TimingAnalyser::walk_levels(bool backward, TFunc func)
 {
-    // Assign initial arrival time to domain startpoints
-    for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
-        auto &dom = domains.at(dom_id);
-        for (auto &sp : dom.startpoints) {
-            auto &pd = ports.at(sp.first);
-            DelayPair init_arrival(0);
-            CellPortKey clock_key;
-            // TODO: clock routing delay, if analysis of that is enabled
-            if (sp.second != IdString()) {
-                // clocked startpoints have a clock-to-out time
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == sp.second) {
-                        init_arrival = init_arrival + fanin.value.delayPair();
-                        break;
-                    }
-                }
-                clock_key = CellPortKey(sp.first.cell, sp.second);
+    int num_levels = int(level_begin.size()) - 1;
+    for (int i = 0; i < num_levels; i++) {
+        int l = backward ? (num_levels - 1 - i) : i;
+        int begin = level_begin.at(l), end = level_begin.at(l + 1);
+        // With loops, edges closing a loop may connect ports of the same level, so everything must be serial. The
+        // Context's threads are only asked for (and started) once a level is large enough to be worth splitting
+        ThreadPool *workers = nullptr;
+        if (!have_loops && (end - begin) >= 2 * min_level_chunk)
+            workers = ctx->getThreadPool();
+        int chunks = workers ? std::min(workers->size(), (end - begin) / min_level_chunk) : 1;
+        if (chunks <= 1) {
+            if (backward) {
+                for (int j = end - 1; j >= begin; j--)
+                    func(topological_order[j]);
+            } else {
+                for (int j = begin; j < end; j++)
+                    func(topological_order[j]);
             }
-            set_arrival_time(sp.first, dom_id, init_arrival, 1, clock_key);
+            continue;
         }
+        // Each port only writes its own times, and only reads those of ports in already completed levels, so the
+        // result doesn't depend on how the level is divided up
+        workers->run(chunks, [&](int c) {
+            int chunk_begin = begin + int((int64_t(end - begin) * c) / chunks);
+            int chunk_end = begin + int((int64_t(end - begin) * (c + 1)) / chunks);
+            for (int j = chunk_begin; j < chunk_end; j++)
+                func(topological_order[j]);
+        });
     }
-    // Walk forward in topological order
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &arr : pd.arrival) {
-            if (pd.type == PORT_OUT) {
-                // Output port: propagate delay through net, adding route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr)
-                    for (auto &usr : net->users) {
-                        CellPortKey usr_key(usr);
-                        auto &usr_pd = ports.at(usr_key);
-                        set_arrival_time(usr_key, arr.first, arr.second.value + usr_pd.route_delay,
-                                         arr.second.path_length, p);
-                    }
-            } else if (pd.type == PORT_IN) {
-                // Input port; propagate delay through cell, adding combinational delay
-                for (auto &fanout : pd.cell_arcs) {
-                    if (fanout.type != CellArc::COMBINATIONAL)
-                        continue;
-                    set_arrival_time(CellPortKey(p.cell, fanout.other_port), arr.first,
-                                     arr.second.value + fanout.value.delayPair(), arr.second.path_length + 1, p);
-                }
-            }
+}
+
+void TimingAnalyser::compute_arrival(int p)
+{
+    auto &pd = ports.at(p);
+    // Domain startpoints (outputs) get their initial arrival time
+    if (pd.type == PORT_OUT)
+        for (int i = pd.seeds_begin; i < pd.seeds_end; i++) {
+            auto &seed = seeds.at(i);
+            set_arrival_time(p, seed.domain, seed.value, 1, seed.clock_port);
+        }
+    // Then pull arrival times from the fanin
+    for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++) {
+        auto &e = edges.at(fanin_edges.at(i));
+        auto &src = ports.at(e.from);
+        // routing edges add route delay; combinational edges add cell delay and increase path length
+        DelayPair delay = e.routing ? pd.route_delay : e.delay;
+        int length_inc = e.routing ? 0 : 1;
+        for (int a = src.arrival_begin; a < src.arrival_end; a++) {
+            auto &arr = arrival.at(a);
+            // The source of an edge closing a loop may not have been visited yet, so its time can still be init_delay;
+            // adding a delay to that would overflow. Min times are never set with setup_only, and are ignored then
+            if (arr.value.max_delay == init_delay.max_delay)
+                continue;
+            DelayPair value(setup_only ? arr.value.max_delay : arr.value.min_delay, arr.value.max_delay);
+            set_arrival_time(p, arr.domain, value + delay, arr.path_length + length_inc, e.from);
         }
     }
 }
 
-void TimingAnalyser::walk_backward()
+void TimingAnalyser::compute_required(int p)
 {
-    // Assign initial required time to domain endpoints
-    // Note that clock frequency will be considered later in the analysis for, for now all required times are normalised
-    // to 0ns
-    for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
-        auto &dom = domains.at(dom_id);
-        for (auto &ep : dom.endpoints) {
-            auto &pd = ports.at(ep.first);
-            DelayPair init_setuphold(0);
-            CellPortKey clock_key;
-            // TODO: clock routing delay, if analysis of that is enabled
-            if (ep.second != IdString()) {
-                // Add setup/hold time, if this endpoint is clocked
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type == CellArc::SETUP && fanin.other_port == ep.second)
-                        init_setuphold.min_delay -= fanin.value.maxDelay();
-                    if (fanin.type == CellArc::HOLD && fanin.other_port == ep.second)
-                        init_setuphold.max_delay -= fanin.value.maxDelay();
+    auto &pd = ports.at(p);
+    // Domain endpoints (inputs) get their initial required time
+    if (pd.type == PORT_IN)
+        for (int i = pd.seeds_begin; i < pd.seeds_end; i++) {
+            auto &seed = seeds.at(i);
+            set_required_time(p, seed.domain, seed.value, 1, seed.clock_port);
+        }
+    // Then pull required times from the fanout
+    for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++) {
+        auto &edge = edges.at(e);
+        auto &dst = ports.at(edge.to);
+        // routing edges subtract route delay; combinational edges subtract cell delay
+        DelayPair delay(edge.routing ? dst.route_delay.maxDelay() : edge.delay.maxDelay());
+        int length_inc = edge.routing ? 0 : 1;
+        for (int r = dst.required_begin; r < dst.required_end; r++) {
+            auto &req = required.at(r);
+            // As in compute_arrival, skip times that are still init_delay
+            if (req.value.min_delay == init_delay.min_delay)
+                continue;
+            DelayPair value(req.value.min_delay, setup_only ? req.value.min_delay : req.value.max_delay);
+            set_required_time(p, req.domain, value - delay, req.path_length + length_inc, edge.to);
+        }
+    }
+}
+
+static DelayPair derate_delay(DelayPair delay, float factor)
+{
+    return DelayPair(delay_t(delay.minDelay() * factor), delay_t(delay.maxDelay() * factor));
+}
+
+void TimingAnalyser::compute_corner_arrival(int p)
+{
+    // Same as compute_arrival, for all corners at once. Corners come after the nominal arrival times of the port, so
+    // we know already which domains arrive here.
+    auto &pd = ports.at(p);
+    const int num_corners = int(corners.size());
+    if (pd.type == PORT_OUT)
+        for (int i = pd.seeds_begin; i < pd.seeds_end; i++) {
+            auto &seed = seeds.at(i);
+            for (int a = pd.arrival_begin; a < pd.arrival_end; a++) {
+                if (arrival.at(a).domain != seed.domain)
+                    continue;
+                DelayPair *times = &corner_arrival.at(a * num_corners);
+                for (int c = 0; c < num_corners; c++) {
+                    DelayPair value = derate_delay(seed.value, corners.at(c).logic_derate);
+                    times[c].min_delay = std::min(times[c].min_delay, value.min_delay);
+                    times[c].max_delay = std::max(times[c].max_delay, value.max_delay);
                 }
-                clock_key = CellPortKey(ep.first.cell, ep.second);
             }
-            set_required_time(ep.first, dom_id, init_setuphold, 1, clock_key);
         }
-    }
-    // Walk backwards in topological order
-    for (auto p : reversed_range(topological_order)) {
-        auto &pd = ports.at(p);
-        for (auto &req : pd.required) {
-            if (pd.type == PORT_IN) {
-                // Input port: propagate delay back through net, subtracting route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr && net->driver.cell != nullptr)
-                    set_required_time(CellPortKey(net->driver), req.first,
-                                      req.second.value - DelayPair(pd.route_delay.maxDelay()), req.second.path_length,
-                                      p);
-            } else if (pd.type == PORT_OUT) {
-                // Output port : propagate delay back through cell, subtracting combinational delay
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type != CellArc::COMBINATIONAL)
+    for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++) {
+        auto &e = edges.at(fanin_edges.at(i));
+        auto &src = ports.at(e.from);
+        DelayPair delay = e.routing ? pd.route_delay : e.delay;
+        for (int s = src.arrival_begin; s < src.arrival_end; s++) {
+            for (int a = pd.arrival_begin; a < pd.arrival_end; a++) {
+                if (arrival.at(a).domain != arrival.at(s).domain)
+                    continue;
+                const DelayPair *src_times = &corner_arrival.at(s * num_corners);
+                DelayPair *times = &corner_arrival.at(a * num_corners);
+                for (int c = 0; c < num_corners; c++) {
+                    // As in compute_arrival, skip corner times of the source that are still init_delay
+                    if (src_times[c].max_delay == init_delay.max_delay)
                         continue;
-                    set_required_time(CellPortKey(p.cell, fanin.other_port), req.first,
-                                      req.second.value - DelayPair(fanin.value.maxDelay()), req.second.path_length + 1,
-                                      p);
+                    auto &corner = corners.at(c);
+                    DelayPair value =
+                            src_times[c] + derate_delay(delay, e.routing ? corner.routing_derate : corner.logic_derate);
+                    times[c].min_delay = std::min(times[c].min_delay, value.min_delay);
+                    times[c].max_delay = std::max(times[c].max_delay, value.max_delay);
                 }
+                break;
             }
         }
     }
 }
 
+void TimingAnalyser::walk_forward()
+{
+    bool with_corners = !corner_arrival.empty();
+    walk_levels(false, [&](int p) {
+        compute_arrival(p);
+        if (with_corners)
+            compute_corner_arrival(p);
+    });
+}
+
+void TimingAnalyser::walk_backward()
+{
+    walk_levels(true, [&](int p) { compute_required(p); });
+}
+
 dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
 {
     dict<domain_id_t, delay_t> domain_delay;
 
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &req : pd.required) {
-            auto &capture = req.first;
-            for (auto &arr : pd.arrival) {
-                auto &launch = arr.first;
-
-                auto dp = domain_pair_id(launch, capture);
+    for (auto &pdp : port_pairs) {
+        auto &arr = arrival.at(pdp.arrival);
+        auto &req = required.at(pdp.required);
 
-                delay_t delay = arr.second.value.maxDelay() - req.second.value.minDelay();
-                if (!domain_delay.count(dp) || domain_delay.at(dp) < delay)
-                    domain_delay[dp] = delay;
-            }
-        }
+        delay_t delay = arr.value.maxDelay() - req.value.minDelay();
+        if (!domain_delay.count(pdp.pair) || domain_delay.at(pdp.pair) < delay)
+            domain_delay[pdp.pair] = delay;
     }
 
     return domain_delay;
 }
 
 void TimingAnalyser::compute_slack()
+{
+    // Get clock-to-clock delay, if any, for each domain pair
+    pair_clock_delay.assign(domain_pairs.size(), 0);
+    for (int i = 0; i < int(domain_pairs.size()); i++) {
+        auto &dp = domain_pairs.at(i);
+        // Get clock names
+        const auto &launch_clock = domains.at(dp.key.launch).key.clock;
+        const auto &capture_clock = domains.at(dp.key.capture).key.clock;
+        auto clocks = std::make_pair(launch_clock, capture_clock);
+        if (clock_delays.count(clocks))
+            pair_clock_delay.at(i) = clock_delays.at(clocks);
+    }
+    for (int p = 0; p < int(ports.size()); p++)
+        compute_port_slack(p);
+    compute_worst_slack();
+}
+
+void TimingAnalyser::compute_port_slack(int p)
+{
+    auto &pd = ports.at(p);
+    pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+    pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+        auto &pdp = port_pairs.at(i);
+        auto &dp = domain_pairs.at(pdp.pair);
+
+        auto &arr = arrival.at(pdp.arrival);
+        auto &req = required.at(pdp.required);
+        delay_t clock_to_clock = pair_clock_delay.at(pdp.pair);
+        pdp.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
+        if (!setup_only)
+            pdp.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
+        pdp.max_path_length = arr.path_length + req.path_length;
+        if (dp.key.launch == dp.key.capture)
+            pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.setup_slack);
+        if (!setup_only)
+            pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.hold_slack);
+    }
+}
+
+void TimingAnalyser::compute_worst_slack()
 {
     for (auto &dp : domain_pairs) {
         dp.worst_setup_slack = std::numeric_limits<delay_t>::max();
         dp.worst_hold_slack = std::numeric_limits<delay_t>::max();
     }
-    for (auto p : topological_order) {
+    for (auto &pdp : port_pairs) {
+        auto &dp = domain_pairs.at(pdp.pair);
+        dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.setup_slack);
+        if (!setup_only)
+            dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.hold_slack);
+    }
+}
+
+void TimingAnalyser::compute_criticality()
+{
+    for (int p = 0; p < int(ports.size()); p++)
+        compute_port_criticality(p);
+}
+
+void TimingAnalyser::compute_port_criticality(int p)
+{
+    auto &pd = ports.at(p);
+    pd.worst_crit = 0;
+    for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+        auto &pdp = port_pairs.at(i);
+        auto &dp = domain_pairs.at(pdp.pair);
+        // Do not set criticality for asynchronous paths
+        if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
+            continue;
+
+        float crit = 1.0f - (float(pdp.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
+        crit = std::min(crit, 1.0f);
+        crit = std::max(crit, 0.0f);
+        pdp.criticality = crit;
+        pd.worst_crit = std::max(pd.worst_crit, crit);
+    }
+}
+
+void TimingAnalyser::run_incremental()
+{
+    if (dirty_ports.empty())
+        return;
+    NPNR_PROFILE_ZONE("sta_incremental");
+    if (have_loops) {
+        // Levels don't bound the cones once there are loops, so just redo everything
+        run(false);
+        return;
+    }
+    int n = int(ports.size());
+    port_queued.resize(n, false);
+    port_touched.resize(n, false);
+    std::vector<int> touched;
+    auto touch = [&](int p) {
+        if (port_touched.at(p))
+            return;
+        port_touched.at(p) = true;
+        touched.push_back(p);
+    };
+    std::vector<ArrivReqTime> old_times;
+    auto times_changed = [&](const std::vector<ArrivReqTime> &times, int begin) {
+        for (int i = 0; i < int(old_times.size()); i++) {
+            const auto &a = old_times.at(i), &b = times.at(begin + i);
+            if (a.value.min_delay != b.value.min_delay || a.value.max_delay != b.value.max_delay ||
+                a.path_length != b.path_length)
+                return true;
+        }
+        return false;
+    };
+    auto reset_range = [&](std::vector<ArrivReqTime> &times, int begin, int end) {
+        old_times.assign(times.begin() + begin, times.begin() + end);
+        for (int i = begin; i < end; i++) {
+            auto &t = times.at(i);
+            t.value = init_delay;
+            t.path_length = 0;
+            t.bwd_min = -1;
+            t.bwd_max = -1;
+        }
+    };
+
+    // Forward cone of the ports with changed route delays, in increasing level order. A port's fanout is only visited
+    // if its arrival times actually changed.
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> fwd;
+    for (int p : dirty_ports) {
+        port_queued.at(p) = true;
+        fwd.emplace(port_level.at(p), p);
+    }
+    while (!fwd.empty()) {
+        int p = fwd.top().second;
+        fwd.pop();
+        port_queued.at(p) = false;
         auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-
-            // Get clock names
-            const auto &launch_clock = domains.at(dp.key.launch).key.clock;
-            const auto &capture_clock = domains.at(dp.key.capture).key.clock;
-
-            // Get clock-to-clock delay if any
-            delay_t clock_to_clock = 0;
-            auto clocks = std::make_pair(launch_clock, capture_clock);
-            if (clock_delays.count(clocks)) {
-                clock_to_clock = clock_delays.at(clocks);
+        reset_range(arrival, pd.arrival_begin, pd.arrival_end);
+        compute_arrival(p);
+        if (!times_changed(arrival, pd.arrival_begin))
+            continue;
+        touch(p);
+        for (int e = fanout_begin.at(p); e < fanout_begin.at(p + 1); e++) {
+            int to = edges.at(e).to;
+            if (!port_queued.at(to)) {
+                port_queued.at(to) = true;
+                fwd.emplace(port_level.at(to), to);
             }
+        }
+    }
 
-            auto &arr = pd.arrival.at(dp.key.launch);
-            auto &req = pd.required.at(dp.key.capture);
-            pdp.second.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
-            if (!setup_only)
-                pdp.second.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
-            pdp.second.max_path_length = arr.path_length + req.path_length;
-            if (dp.key.launch == dp.key.capture)
-                pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.second.setup_slack);
-            dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.second.setup_slack);
-            if (!setup_only) {
-                pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.second.hold_slack);
-                dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.second.hold_slack);
+    // Backward cone, starting from the drivers of the changed ports, in decreasing level order
+    std::priority_queue<std::pair<int, int>> bwd;
+    for (int p : dirty_ports) {
+        for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++) {
+            int from = edges.at(fanin_edges.at(i)).from;
+            if (!port_queued.at(from)) {
+                port_queued.at(from) = true;
+                bwd.emplace(port_level.at(from), from);
+            }
+        }
+    }
+    while (!bwd.empty()) {
+        int p = bwd.top().second;
+        bwd.pop();
+        port_queued.at(p) = false;
+        auto &pd = ports.at(p);
+        reset_range(required, pd.required_begin, pd.required_end);
+        compute_required(p);
+        if (!times_changed(required, pd.required_begin))
+            continue;
+        touch(p);
+        for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++) {
+            int from = edges.at(fanin_edges.at(i)).from;
+            if (!port_queued.at(from)) {
+                port_queued.at(from) = true;
+                bwd.emplace(port_level.at(from), from);
             }
         }
     }
-}
 
-void TimingAnalyser::compute_criticality()
-{
-    for (auto p : topological_order) {
+    // Update slack of the touched ports. The worst slack of a domain pair only needs a full rescan if a port that was
+    // at the worst slack got better.
+    bool rescan = false, worst_changed = false;
+    std::vector<delay_t> old_slack;
+    for (int p : touched) {
         auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-            // Do not set criticality for asynchronous paths
-            if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
+        old_slack.clear();
+        for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+            old_slack.push_back(port_pairs.at(i).setup_slack);
+            old_slack.push_back(port_pairs.at(i).hold_slack);
+        }
+        compute_port_slack(p);
+        for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+            auto &pdp = port_pairs.at(i);
+            auto &dp = domain_pairs.at(pdp.pair);
+            delay_t old_setup = old_slack.at(2 * (i - pd.pairs_begin)),
+                    old_hold = old_slack.at(2 * (i - pd.pairs_begin) + 1);
+            if (pdp.setup_slack < dp.worst_setup_slack) {
+                dp.worst_setup_slack = pdp.setup_slack;
+                worst_changed = true;
+            } else if (old_setup == dp.worst_setup_slack && pdp.setup_slack > old_setup) {
+                rescan = true;
+            }
+            if (setup_only)
                 continue;
-
-            float crit =
-                    1.0f - (float(pdp.second.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
-            crit = std::min(crit, 1.0f);
-            crit = std::max(crit, 0.0f);
-            pdp.second.criticality = crit;
-            pd.worst_crit = std::max(pd.worst_crit, crit);
+            if (pdp.hold_slack < dp.worst_hold_slack)
+                dp.worst_hold_slack = pdp.hold_slack;
+            else if (old_hold == dp.worst_hold_slack && pdp.hold_slack > old_hold)
+                rescan = true;
         }
     }
+    if (rescan) {
+        std::vector<delay_t> old_worst;
+        for (auto &dp : domain_pairs)
+            old_worst.push_back(dp.worst_setup_slack);
+        compute_worst_slack();
+        for (int i = 0; i < int(domain_pairs.size()); i++)
+            worst_changed |= (domain_pairs.at(i).worst_setup_slack != old_worst.at(i));
+    }
+
+    // Criticality is relative to the worst slack; so if that changed everything needs updating
+    if (worst_changed) {
+        compute_criticality();
+    } else {
+        for (int p : touched)
+            compute_port_criticality(p);
+    }
+
+    for (int p : touched)
+        port_touched.at(p) = false;
+    clear_dirty();
 }
 
 void TimingAnalyser::build_detailed_net_timing_report()
@@ -745,12 +1234,13 @@ void TimingAnalyser::build_detailed_net_timing_report()
         auto &dom = domains.at(dom_id);
         for (auto &ep : dom.endpoints) {
             auto &pd = ports.at(ep.first);
-            const NetInfo *net = port_info(ep.first).net;
+            const NetInfo *net = port_info(pd.cell_port).net;
 
-            for (auto &arr : pd.arrival) {
-                auto &launch = domains.at(arr.first).key;
-                for (auto &req : pd.required) {
-                    auto &capture = domains.at(req.first).key;
+            for (int a = pd.arrival_begin; a < pd.arrival_end; a++) {
+                auto &arr = arrival.at(a);
+                auto &launch = domains.at(arr.domain).key;
+                for (int r = pd.required_begin; r < pd.required_end; r++) {
+                    auto &capture = domains.at(required.at(r).domain).key;
 
                     NetSinkTiming sink_timing;
                     sink_timing.clock_pair.start.clock = launch.clock;
@@ -758,7 +1248,7 @@ void TimingAnalyser::build_detailed_net_timing_report()
                     sink_timing.clock_pair.end.clock = capture.clock;
                     sink_timing.clock_pair.end.edge = capture.edge;
                     sink_timing.cell_port = std::make_pair(pd.cell_port.cell, pd.cell_port.port);
-                    sink_timing.delay = arr.second.value.max_delay;
+                    sink_timing.delay = arr.value.max_delay;
 
                     net_timings[net->name].push_back(sink_timing);
                 }
@@ -767,34 +1257,142 @@ void TimingAnalyser::build_detailed_net_timing_report()
     }
 }
 
-std::vector<CellPortKey> TimingAnalyser::get_worst_eps(domain_id_t domain_pair, int count)
+std::vector<std::vector<int>> TimingAnalyser::get_worst_paths(domain_id_t domain_pair, int count, int per_endpoint)
 {
-    std::vector<CellPortKey> worst_eps;
-    delay_t last_slack = std::numeric_limits<delay_t>::lowest();
+    // Paths are enumerated lazily in order of decreasing delay by deviation: the worst path through a given port to
+    // an endpoint follows the worst arrival time back from that port. Each path produced then spawns new partial paths
+    // that differ from it by taking a different fanin (or stopping at a startpoint) at one port, so no path is produced
+    // twice and only the paths actually reported are ever explored.
+    std::vector<std::vector<int>> paths;
     auto &dp = domain_pairs.at(domain_pair);
-    auto &cap_d = domains.at(dp.key.capture);
-    while (int(worst_eps.size()) < count) {
-        CellPortKey next;
-        delay_t next_slack = std::numeric_limits<delay_t>::max();
-        for (auto ep : cap_d.endpoints) {
-            auto &pd = ports.at(ep.first);
-            if (!pd.domain_pairs.count(domain_pair))
+    domain_id_t launch = dp.key.launch, capture = dp.key.capture;
+
+    // Suffixes of partial paths (from a port to its endpoint) are shared, as linked lists towards the endpoint
+    struct SuffixEntry
+    {
+        int port;
+        int next;
+    };
+    std::vector<SuffixEntry> suffixes;
+    // A partial path to an endpoint. It starts with the worst path to port; or at the startpoint seed of port, if
+    // seed is set. suffix_delay is the delay from port to the endpoint, less the required time at the endpoint.
+    struct PartialPath
+    {
+        delay_t delay;
+        int order;
+        int port, suffix, seed, endpoint;
+        delay_t suffix_delay;
+        bool operator<(const PartialPath &other) const
+        {
+            // earlier partial paths first, for ties; matching the order endpoints are considered in
+            return delay < other.delay || (delay == other.delay && order > other.order);
+        }
+    };
+    std::priority_queue<PartialPath> queue;
+    int next_order = 0;
+
+    // Start with the worst path to each endpoint
+    pool<int> listed;
+    for (auto &ep : domains.at(capture).endpoints) {
+        auto &pd = ports.at(ep.first);
+        auto arr = find_time(arrival, pd.arrival_begin, pd.arrival_end, launch);
+        auto req = find_time(required, pd.required_begin, pd.required_end, capture);
+        // endpoints may be listed more than once, with different clock ports
+        if (arr == nullptr || req == nullptr || !listed.insert(ep.first).second)
+            continue;
+        queue.push(PartialPath{arr->value.maxDelay() - req->value.minDelay(), next_order++, ep.first, -1, -1, ep.first,
+                               -req->value.minDelay()});
+    }
+
+    // The ways of arriving at a port: from a startpoint seed, or along a fanin edge
+    struct Arrival
+    {
+        int seed, from;
+        delay_t value, edge_delay;
+    };
+    std::vector<Arrival> arrivals;
+    auto get_arrivals = [&](int p) {
+        arrivals.clear();
+        auto &pd = ports.at(p);
+        if (pd.type == PORT_OUT)
+            for (int i = pd.seeds_begin; i < pd.seeds_end; i++)
+                if (seeds.at(i).domain == launch)
+                    arrivals.push_back(Arrival{i, -1, seeds.at(i).value.maxDelay(), 0});
+        for (int i = fanin_begin.at(p); i < fanin_begin.at(p + 1); i++) {
+            auto &e = edges.at(fanin_edges.at(i));
+            auto &src = ports.at(e.from);
+            auto arr = find_time(arrival, src.arrival_begin, src.arrival_end, launch);
+            if (arr == nullptr)
                 continue;
-            delay_t ep_slack = pd.domain_pairs.at(domain_pair).setup_slack;
-            if (ep_slack < next_slack && ep_slack > last_slack) {
-                next = ep.first;
-                next_slack = ep_slack;
+            delay_t edge_delay = e.routing ? pd.route_delay.maxDelay() : e.delay.maxDelay();
+            arrivals.push_back(Arrival{-1, e.from, arr->value.maxDelay() + edge_delay, edge_delay});
+        }
+    };
+
+    dict<int, int> endpoint_paths;
+    while (!queue.empty() && int(paths.size()) < count) {
+        PartialPath curr = queue.top();
+        queue.pop();
+        if (per_endpoint > 0 && endpoint_paths[curr.endpoint] >= per_endpoint)
+            continue;
+        ++endpoint_paths[curr.endpoint];
+
+        // Follow the worst arrival back from the first port, adding the deviations along the way
+        std::vector<int> prefix;
+        int port = curr.port, suffix = curr.suffix;
+        delay_t suffix_delay = curr.suffix_delay;
+        while (true) {
+            prefix.push_back(port);
+            if (curr.seed != -1 || int(prefix.size()) > int(ports.size()))
+                break;
+            get_arrivals(port);
+            int worst = -1;
+            for (int i = 0; i < int(arrivals.size()); i++)
+                if (worst == -1 || arrivals.at(i).value > arrivals.at(worst).value)
+                    worst = i;
+            if (worst == -1)
+                break;
+            int port_suffix = -1;
+            for (int i = 0; i < int(arrivals.size()); i++) {
+                auto &a = arrivals.at(i);
+                if (i == worst)
+                    continue;
+                if (a.seed != -1) {
+                    queue.push(PartialPath{a.value + suffix_delay, next_order++, port, suffix, a.seed, curr.endpoint,
+                                           suffix_delay});
+                } else {
+                    if (port_suffix == -1) {
+                        port_suffix = int(suffixes.size());
+                        suffixes.push_back(SuffixEntry{port, suffix});
+                    }
+                    queue.push(PartialPath{a.value + suffix_delay, next_order++, a.from, port_suffix, -1,
+                                           curr.endpoint, suffix_delay + a.edge_delay});
+                }
+            }
+            auto &next = arrivals.at(worst);
+            if (next.seed != -1)
+                break;
+            if (port_suffix == -1) {
+                port_suffix = int(suffixes.size());
+                suffixes.push_back(SuffixEntry{port, suffix});
             }
+            suffix = port_suffix;
+            suffix_delay += next.edge_delay;
+            port = next.from;
         }
-        if (next == CellPortKey())
-            break;
-        worst_eps.push_back(next);
-        last_slack = next_slack;
+
+        // Paths are listed from the endpoint back to the startpoint
+        std::vector<int> path;
+        for (int i = curr.suffix; i != -1; i = suffixes.at(i).next)
+            path.push_back(suffixes.at(i).port);
+        std::reverse(path.begin(), path.end());
+        path.insert(path.end(), prefix.begin(), prefix.end());
+        paths.push_back(std::move(path));
     }
-    return worst_eps;
+    return paths;
 }
 
-CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint)
+CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, const std::vector<int> &path)
 {
     CriticalPath report;
 
@@ -824,11 +1422,11 @@ CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair,
 
     pool<std::pair<IdString, IdString>> visited;
     std::vector<PortRef> crit_path_rev;
-    auto cursor = endpoint;
 
-    while (cursor != CellPortKey()) {
-        auto cell = cell_info(cursor);
-        auto &port = port_info(cursor);
+    for (int p : path) {
+        auto &pd = ports.at(p);
+        auto cell = pd.cell;
+        auto &port = cell->ports.at(pd.cell_port.port);
 
         int port_clocks;
         auto portClass = ctx->getPortTimingClass(cell, port.name, port_clocks);
@@ -839,11 +1437,6 @@ CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair,
 
         if (portClass != TMG_CLOCK_INPUT && portClass != TMG_IGNORE && port.type == PortType::PORT_IN)
             crit_path_rev.emplace_back(PortRef{cell, port.name});
-
-        if (!ports.at(cursor).arrival.count(dp.key.launch))
-            break;
-
-        cursor = ports.at(cursor).arrival.at(dp.key.launch).bwd_max;
     }
 
     auto crit_path = boost::adaptors::reverse(crit_path_rev);
@@ -943,6 +1536,10 @@ void TimingAnalyser::build_crit_path_reports()
 
     auto delay_by_domain = max_delay_by_domain_pairs();
 
+    // Paths beyond the worst, when more than one is requested per domain pair
+    dict<IdString, std::vector<CriticalPath>> near_crit_paths;
+    std::vector<CriticalPath> near_crit_reports;
+
     for (int i = 0; i < int(domains.size()); i++) {
         empty_clocks.insert(domains.at(i).key.clock);
     }
@@ -969,14 +1566,17 @@ void TimingAnalyser::build_crit_path_reports()
             if (ctx->nets.at(launch.clock)->clkconstr)
                 target = 1000 / ctx->getDelayNS(ctx->nets.at(launch.clock)->clkconstr->period.minDelay());
 
-            auto worst_endpoint = get_worst_eps(i, 1);
-            if (worst_endpoint.empty())
+            auto worst_paths = get_worst_paths(i, std::max(1, ctx->report_paths), ctx->report_paths_per_endpoint);
+            if (worst_paths.empty())
                 continue;
 
             clock_fmax[launch.clock].achieved = Fmax;
             clock_fmax[launch.clock].constraint = target;
 
-            clock_reports[launch.clock] = build_critical_path_report(i, worst_endpoint.at(0));
+            clock_reports[launch.clock] = build_critical_path_report(i, worst_paths.at(0));
+            near_crit_paths[launch.clock].clear();
+            for (int j = 1; j < int(worst_paths.size()); j++)
+                near_crit_paths[launch.clock].push_back(build_critical_path_report(i, worst_paths.at(j)));
 
             empty_clocks.erase(launch.clock);
         }
@@ -990,11 +1590,13 @@ void TimingAnalyser::build_crit_path_reports()
         if (launch.clock == capture.clock && !launch.is_async())
             continue;
 
-        auto worst_endpoint = get_worst_eps(i, 1);
-        if (worst_endpoint.empty())
+        auto worst_paths = get_worst_paths(i, std::max(1, ctx->report_paths), ctx->report_paths_per_endpoint);
+        if (worst_paths.empty())
             continue;
 
-        xclock_reports.emplace_back(build_critical_path_report(i, worst_endpoint.at(0)));
+        xclock_reports.emplace_back(build_critical_path_report(i, worst_paths.at(0)));
+        for (int j = 1; j < int(worst_paths.size()); j++)
+            near_crit_reports.push_back(build_critical_path_report(i, worst_paths.at(j)));
     }
 
     auto cmp_crit_path = [&](const CriticalPath &ra, const CriticalPath &rb) {
@@ -1020,9 +1622,125 @@ void TimingAnalyser::build_crit_path_reports()
 
     std::sort(xclock_reports.begin(), xclock_reports.end(), cmp_crit_path);
 
+    for (auto &clock : clock_reports)
+        for (auto &path : near_crit_paths[clock.first])
+            result.near_critical_paths.push_back(std::move(path));
+    std::stable_sort(near_crit_reports.begin(), near_crit_reports.end(), cmp_crit_path);
+    for (auto &path : near_crit_reports)
+        result.near_critical_paths.push_back(std::move(path));
+
     clock_delays_ctx = clock_delays;
 }
 
+void TimingAnalyser::build_corner_reports()
+{
+    if (corner_arrival.empty())
+        return;
+    const int num_corners = int(corners.size());
+    for (int c = 0; c < num_corners; c++) {
+        auto &corner = corners.at(c);
+        auto &corner_result = result.corners[corner.name];
+        for (int i = 0; i < int(domain_pairs.size()); i++) {
+            auto &dp = domain_pairs.at(i);
+            auto &launch = domains.at(dp.key.launch).key;
+            auto &capture = domains.at(dp.key.capture).key;
+            if (launch.clock != capture.clock || launch.is_async())
+                continue;
+            // Setup and hold checks at each endpoint, against its own setup/hold times
+            delay_t clock_to_clock = delay_t(pair_clock_delay.at(i) * corner.routing_derate);
+            delay_t path_delay = std::numeric_limits<delay_t>::lowest();
+            delay_t hold_slack = std::numeric_limits<delay_t>::max();
+            for (auto &ep : domains.at(dp.key.capture).endpoints) {
+                auto &pd = ports.at(ep.first);
+                auto arr = find_time(arrival, pd.arrival_begin, pd.arrival_end, dp.key.launch);
+                if (arr == nullptr)
+                    continue;
+                const DelayPair &arr_time = corner_arrival.at((arr - arrival.data()) * num_corners + c);
+                for (int s = pd.seeds_begin; s < pd.seeds_end; s++) {
+                    auto &seed = seeds.at(s);
+                    if (seed.domain != dp.key.capture || pd.type != PORT_IN)
+                        continue;
+                    DelayPair req_time = derate_delay(seed.value, corner.logic_derate);
+                    path_delay = std::max(path_delay, arr_time.maxDelay() - req_time.minDelay() + clock_to_clock);
+                    hold_slack = std::min(hold_slack, arr_time.minDelay() - req_time.maxDelay() + clock_to_clock);
+                }
+            }
+            if (path_delay == std::numeric_limits<delay_t>::lowest())
+                continue;
+
+            double Fmax;
+            if (launch.edge == capture.edge)
+                Fmax = 1000 / ctx->getDelayNS(path_delay);
+            else
+                Fmax = 500 / ctx->getDelayNS(path_delay);
+            if (!corner_result.clock_fmax.count(launch.clock) ||
+                Fmax < corner_result.clock_fmax.at(launch.clock).achieved) {
+                corner_result.clock_fmax[launch.clock].achieved = Fmax;
+                corner_result.clock_fmax[launch.clock].constraint =
+                        result.clock_fmax.count(launch.clock) ? result.clock_fmax.at(launch.clock).constraint : 0;
+            }
+            if (!corner_result.clock_hold_slack.count(launch.clock) ||
+                hold_slack < corner_result.clock_hold_slack.at(launch.clock))
+                corner_result.clock_hold_slack[launch.clock] = hold_slack;
+        }
+    }
+}
+
+void TimingAnalyser::build_cdc_report()
+{
+    // Find the crossing domain pairs up front, so the per-port scan below is only table lookups
+    std::vector<int> crossing_index(domain_pairs.size(), -1);
+    for (int i = 0; i < int(domain_pairs.size()); i++) {
+        auto &dp = domain_pairs.at(i);
+        auto &launch = domains.at(dp.key.launch).key;
+        auto &capture = domains.at(dp.key.capture).key;
+        if (launch.clock == capture.clock || launch.is_async() || capture.is_async())
+            continue;
+        crossing_index.at(i) = int(result.clock_crossings.size());
+        result.clock_crossings.emplace_back();
+        auto &crossing = result.clock_crossings.back();
+        crossing.clock_pair.start = ClockEvent{launch.clock, launch.edge};
+        crossing.clock_pair.end = ClockEvent{capture.clock, capture.edge};
+        crossing.unconstrained = !clock_delays.count(std::make_pair(launch.clock, capture.clock));
+    }
+    if (result.clock_crossings.empty())
+        return;
+
+    // A crossing arc is the final arc into an endpoint, where the capturing domain is seeded and a domain of another
+    // clock arrives
+    for (int p = 0; p < int(ports.size()); p++) {
+        auto &pd = ports.at(p);
+        if (pd.type != PORT_IN || pd.seeds_begin == pd.seeds_end)
+            continue;
+        for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+            auto &pdp = port_pairs.at(i);
+            int idx = crossing_index.at(pdp.pair);
+            if (idx == -1)
+                continue;
+            domain_id_t capture = required.at(pdp.required).domain;
+            bool is_endpoint = false;
+            for (int s = pd.seeds_begin; s < pd.seeds_end; s++)
+                if (seeds.at(s).domain == capture)
+                    is_endpoint = true;
+            if (!is_endpoint)
+                continue;
+            const NetInfo *net = port_info(pd.cell_port).net;
+            if (net == nullptr || net->driver.cell == nullptr)
+                continue;
+            ClockCrossing::Arc arc;
+            arc.net = net->name;
+            arc.from = std::make_pair(net->driver.cell->name, net->driver.port);
+            arc.to = std::make_pair(pd.cell_port.cell, pd.cell_port.port);
+            result.clock_crossings.at(idx).arcs.push_back(arc);
+        }
+    }
+
+    // Domain pairs can exist without any crossing arcs into endpoints, for example through combinational outputs
+    result.clock_crossings.erase(std::remove_if(result.clock_crossings.begin(), result.clock_crossings.end(),
+                                                [](const ClockCrossing &c) { return c.arcs.empty(); }),
+                                 result.clock_crossings.end());
+}
+
 void TimingAnalyser::build_slack_histogram_report()
 {
     auto &slack_histogram = result.slack_histogram;
@@ -1031,10 +1749,12 @@ void TimingAnalyser::build_slack_histogram_report()
         for (auto &ep : domains.at(dom_id).endpoints) {
             auto &pd = ports.at(ep.first);
 
-            for (auto &req : pd.required) {
-                auto &capture = domains.at(req.first).key;
-                for (auto &arr : pd.arrival) {
-                    auto &launch = domains.at(arr.first).key;
+            for (int r = pd.required_begin; r < pd.required_end; r++) {
+                auto &req = required.at(r);
+                auto &capture = domains.at(req.domain).key;
+                for (int a = pd.arrival_begin; a < pd.arrival_end; a++) {
+                    auto &arr = arrival.at(a);
+                    auto &launch = domains.at(arr.domain).key;
 
                     if (launch.clock != capture.clock || launch.is_async())
                         continue;
@@ -1046,7 +1766,7 @@ void TimingAnalyser::build_slack_histogram_report()
                     if (launch.edge != capture.edge)
                         clk_period = clk_period / 2;
 
-                    delay_t delay = arr.second.value.maxDelay() - req.second.value.minDelay();
+                    delay_t delay = arr.value.maxDelay() - req.value.minDelay();
                     delay_t slack = clk_period - delay;
 
                     int slack_ps = ctx->getDelayNS(slack) * 1000;
@@ -1075,20 +1795,21 @@ domain_id_t TimingAnalyser::domain_id(const NetInfo *net, ClockEdge edge)
 
 domain_id_t TimingAnalyser::domain_pair_id(domain_id_t launch, domain_id_t capture)
 {
-    ClockDomainPairKey key{launch, capture};
-    auto inserted = pair_to_id.emplace(key, domain_pairs.size());
-    if (inserted.second) {
-        domain_pairs.emplace_back(key);
+    if (int(domains.size()) > pair_matrix_dim) {
+        // Domains are only added during setup, so grow the matrix geometrically and re-populate it from the pair list
+        pair_matrix_dim = std::max(int(domains.size()), 2 * pair_matrix_dim);
+        pair_matrix.assign(size_t(pair_matrix_dim) * pair_matrix_dim, -1);
+        for (domain_id_t i = 0; i < domain_id_t(domain_pairs.size()); i++) {
+            auto &key = domain_pairs.at(i).key;
+            pair_matrix.at(size_t(key.launch) * pair_matrix_dim + key.capture) = i;
+        }
     }
-    return inserted.first->second;
-}
-
-void TimingAnalyser::copy_domains(const CellPortKey &from, const CellPortKey &to, bool backward)
-{
-    auto &f = ports.at(from), &t = ports.at(to);
-    for (auto &dom : (backward ? f.required : f.arrival)) {
-        updated_domains |= (backward ? t.required : t.arrival).emplace(dom.first, ArrivReqTime{}).second;
+    domain_id_t &id = pair_matrix.at(size_t(launch) * pair_matrix_dim + capture);
+    if (id == -1) {
+        id = domain_id_t(domain_pairs.size());
+        domain_pairs.emplace_back(ClockDomainPairKey{launch, capture});
     }
+    return id;
 }
 
 CellInfo *TimingAnalyser::cell_info(const CellPortKey &key) { return ctx->cells.at(key.cell).get(); }
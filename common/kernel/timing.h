@@ -22,6 +22,7 @@
 #define TIMING_H
 
 #include "nextpnr.h"
+#include "thread_pool.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -83,14 +84,23 @@ struct TimingAnalyser
     // This is used when routers etc are not actually binding detailed routing (due to congestion or an abstracted
     // model), but want to re-run STA with their own calculated delays
     void set_route_delay(CellPortKey port, DelayPair value);
+    // Recompute the route delays of all users of a net, for example after some of the cells it connects have moved
+    void update_net_delays(const NetInfo *net);
 
-    float get_criticality(CellPortKey port) const { return ports.at(port).worst_crit; }
-    float get_setup_slack(CellPortKey port) const { return ports.at(port).worst_setup_slack; }
+    // Incremental analysis, applying only the route delays changed since the last run or run_incremental. Only the
+    // forward cone (for arrival times) and backward cone (for required times) of the changed ports are re-walked, and
+    // slack and criticality are only recomputed for ports whose times changed, unless the worst slack of a domain pair
+    // moves. Reports are not updated. run() or setup() must have been called at least once beforehand.
+    void run_incremental();
+
+    float get_criticality(CellPortKey port) const { return ports.at(port_index.at(port)).worst_crit; }
+    float get_setup_slack(CellPortKey port) const { return ports.at(port_index.at(port)).worst_setup_slack; }
     float get_domain_setup_slack(CellPortKey port) const
     {
         delay_t slack = std::numeric_limits<delay_t>::max();
-        for (const auto &dp : ports.at(port).domain_pairs)
-            slack = std::min(slack, domain_pairs.at(dp.first).worst_setup_slack);
+        auto &pd = ports.at(port_index.at(port));
+        for (int i = pd.pairs_begin; i < pd.pairs_end; i++)
+            slack = std::min(slack, domain_pairs.at(port_pairs.at(i).pair).worst_setup_slack);
         return slack;
     }
 
@@ -98,57 +108,88 @@ struct TimingAnalyser
 
     TimingResult &get_timing_result() { return result; }
 
+    // Write the analysed timing graph, times and slacks as a compact columnar binary database (see timing_db.cc)
+    void write_database(std::ostream &out);
+
     bool setup_only = false;
     bool have_loops = false;
     bool updated_domains = false;
 
   private:
     void init_ports();
+    // Arch timing data of a port, only queried the first time it is needed during setup()
+    struct PortTiming;
+    const PortTiming &get_port_timing(const CellInfo *ci, IdString port);
     void get_cell_delays();
+    void build_graph();
     void get_route_delays();
     void topo_sort();
     void setup_port_domains();
     void identify_related_domains();
 
+    void setup_seeds();
+    void setup_corners();
+
     void reset_times();
 
+    // Compute the arrival/required times of a single port from its startpoint/endpoint seeds and fanin/fanout,
+    // assuming its entries have been reset
+    void compute_arrival(int port);
+    void compute_required(int port);
+    // Compute the arrival times of a port at every corner, after its nominal arrival times
+    void compute_corner_arrival(int port);
+
     void walk_forward();
     void walk_backward();
 
+    // Call func(port) for every port, level by level in forward or backward topological order. Ports within a level
+    // are independent, so large levels are split across the thread pool.
+    template <typename TFunc> void walk_levels(bool backward, TFunc func);
+
     void compute_slack();
+    void compute_port_slack(int port);
+    void compute_worst_slack();
     void compute_criticality();
+    void compute_port_criticality(int port);
+
+    void clear_dirty();
 
     void build_detailed_net_timing_report();
-    CriticalPath build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint);
+    CriticalPath build_critical_path_report(domain_id_t domain_pair, const std::vector<int> &path);
     void build_crit_path_reports();
     void build_slack_histogram_report();
+    void build_corner_reports();
+    void build_cdc_report();
 
     dict<domain_id_t, delay_t> max_delay_by_domain_pairs();
 
-    // get the N worst endpoints for a given domain pair
-    std::vector<CellPortKey> get_worst_eps(domain_id_t domain_pair, int count);
+    // get the N worst paths for a given domain pair, at most per_endpoint (if nonzero) ending at each endpoint; each
+    // path is a list of ports from the endpoint back to the startpoint
+    std::vector<std::vector<int>> get_worst_paths(domain_id_t domain_pair, int count, int per_endpoint);
 
     const DelayPair init_delay{std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest()};
 
     // Set arrival/required times if more/less than the current value
-    void set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                          CellPortKey prev = CellPortKey());
-    void set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                           CellPortKey prev = CellPortKey());
+    void set_arrival_time(int target, domain_id_t domain, DelayPair arrival, int path_length, int prev = -1);
+    void set_required_time(int target, domain_id_t domain, DelayPair required, int path_length, int prev = -1);
 
     // To avoid storing the domain tag structure (which could get large when considering more complex constrained tag
     // cases), assign each domain an ID and use that instead
-    // An arrival or required time entry. Stores both the min/max delays; and the traversal to reach them for critical
-    // path reporting
+    // An arrival or required time entry. Stores both the min/max delays; and the traversal (as port indices) to reach
+    // them for critical path reporting
     struct ArrivReqTime
     {
+        domain_id_t domain;
         DelayPair value;
-        CellPortKey bwd_min, bwd_max;
-        int path_length;
+        int bwd_min = -1, bwd_max = -1;
+        int path_length = 0;
     };
     // Data per port-domain tuple
     struct PortDomainPairData
     {
+        domain_id_t pair;
+        // indices into the flat arrival and required arrays
+        int arrival, required;
         delay_t setup_slack = std::numeric_limits<delay_t>::max(), hold_slack = std::numeric_limits<delay_t>::max();
         int max_path_length = 0;
         float criticality = 0;
@@ -179,15 +220,30 @@ struct TimingAnalyser
                 : type(type), other_port(other_port), value(value), edge(edge){};
     };
 
+    // Timing data of a cell port as given by the Arch API
+    struct PortTiming
+    {
+        bool queried = false;
+        TimingPortClass port_class = TMG_IGNORE;
+        // Only queried for register inputs and outputs
+        std::vector<TimingClockingInfo> clocking;
+        // Combinational arcs from other ports (for inputs, to connected outputs; for outputs, from connected
+        // inputs). Not queried for inout ports
+        std::vector<std::pair<IdString, DelayQuad>> comb_arcs;
+    };
+
     // Timing data for every cell port
     struct PerPort
     {
         CellPortKey cell_port;
         PortType type;
-        // per domain timings
-        dict<domain_id_t, ArrivReqTime> arrival;
-        dict<domain_id_t, ArrivReqTime> required;
-        dict<domain_id_t, PortDomainPairData> domain_pairs;
+        CellInfo *cell = nullptr;
+        // per domain timings, as [begin, end) ranges into the flat arrival, required and port_pairs arrays
+        int arrival_begin = 0, arrival_end = 0;
+        int required_begin = 0, required_end = 0;
+        int pairs_begin = 0, pairs_end = 0;
+        // initial times as a startpoint (outputs) or endpoint (inputs), as a range into seeds
+        int seeds_begin = 0, seeds_end = 0;
         // cell timing arcs to (outputs)/from (inputs)  from this port
         std::vector<CellArc> cell_arcs;
         // routing delay into this port (input ports only)
@@ -196,14 +252,41 @@ struct TimingAnalyser
         float worst_crit = 0;
         delay_t worst_setup_slack = std::numeric_limits<delay_t>::max(),
                 worst_hold_slack = std::numeric_limits<delay_t>::max();
+        // route delay changed since the last analysis
+        bool dirty = false;
+    };
+
+    // Initial arrival time of a startpoint or required time of an endpoint
+    struct TimeSeed
+    {
+        domain_id_t domain;
+        DelayPair value;
+        // clock port index, for critical path reporting
+        int clock_port;
+    };
+
+    // An edge of the timing graph; either a routing arc from a net driver to a user, or a combinational arc through a
+    // cell. Routing edges take their delay from the route_delay of the sink port.
+    struct TimingEdge
+    {
+        int from, to;
+        bool routing;
+        DelayPair delay;
     };
 
     struct PerDomain
     {
         PerDomain(ClockDomainKey key) : key(key){};
         ClockDomainKey key;
-        // these are pairs (signal port; clock port)
-        std::vector<std::pair<CellPortKey, IdString>> startpoints, endpoints;
+        // these are pairs (signal port index; clock port)
+        std::vector<std::pair<int, IdString>> startpoints, endpoints;
+    };
+
+    // An additional corner, analysed by scaling the nominal cell and routing delays
+    struct TimingCorner
+    {
+        IdString name;
+        float logic_derate = 1, routing_derate = 1;
     };
 
     struct PerDomainPair
@@ -221,16 +304,56 @@ struct TimingAnalyser
     domain_id_t domain_id(const NetInfo *net, ClockEdge edge);
     domain_id_t domain_pair_id(domain_id_t launch, domain_id_t capture);
 
-    void copy_domains(const CellPortKey &from, const CellPortKey &to, bool backwards);
+    ArrivReqTime *find_time(std::vector<ArrivReqTime> &times, int begin, int end, domain_id_t domain)
+    {
+        for (int i = begin; i < end; i++)
+            if (times[i].domain == domain)
+                return &times[i];
+        return nullptr;
+    }
+
+    // Dense per-port storage, indexed by the values of port_index
+    dict<CellPortKey, int> port_index;
+    std::vector<PerPort> ports;
+    // Arch timing data of each port, only kept while setup() runs: cells may be edited in ways the analyser can't see
+    // between setups, so each setup asks the Arch again
+    std::vector<PortTiming> port_timing;
+    // Flat per-port, per-domain timing data; see the ranges in PerPort
+    std::vector<ArrivReqTime> arrival, required;
+    std::vector<PortDomainPairData> port_pairs;
+    std::vector<TimeSeed> seeds;
+    // Additional corners, and arrival times at each, with the corner times of arrival[i] at
+    // corner_arrival[i * corners.size()..(i + 1) * corners.size()). These are only propagated when building reports.
+    std::vector<TimingCorner> corners;
+    std::vector<DelayPair> corner_arrival;
+    // Timing graph in CSR form. edges is sorted by source port, with fanout_begin[p]..fanout_begin[p+1] the fanout
+    // edges of port p; fanin_edges[fanin_begin[p]..fanin_begin[p+1]] are the indices of its fanin edges.
+    std::vector<TimingEdge> edges;
+    std::vector<int> fanout_begin, fanin_begin, fanin_edges;
 
-    dict<CellPortKey, PerPort> ports;
     dict<ClockDomainKey, domain_id_t> domain_to_id;
-    dict<ClockDomainPairKey, domain_id_t> pair_to_id;
+    // Dense launch x capture matrix of domain pair IDs (-1 where there is no pair yet), with pair_matrix_dim rows
+    std::vector<domain_id_t> pair_matrix;
+    int pair_matrix_dim = 0;
     std::vector<PerDomain> domains;
     std::vector<PerDomainPair> domain_pairs;
     dict<std::pair<IdString, IdString>, delay_t> clock_delays;
 
-    std::vector<CellPortKey> topological_order;
+    // Port indices sorted by level, where every port comes after all its fanin (ignoring loop-closing edges);
+    // level_begin[l]..level_begin[l+1] is the range of topological_order at level l
+    std::vector<int> topological_order;
+    std::vector<int> level_begin;
+    std::vector<int> port_level;
+
+    // Ports with a changed route delay, since the last analysis
+    std::vector<int> dirty_ports;
+    // Scratch flags for incremental analysis
+    std::vector<bool> port_queued, port_touched;
+    // Clock-to-clock delay for each domain pair
+    std::vector<delay_t> pair_clock_delay;
+
+    // Smallest number of ports in a level worth handing to another thread
+    static constexpr int min_level_chunk = 256;
 
     domain_id_t async_clock_id;
 
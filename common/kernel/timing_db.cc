@@ -0,0 +1,260 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include "nextpnr.h"
+#include "timing.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+/*
+Binary timing database, for querying the results of a timing analysis offline without re-running nextpnr. All values
+are little-endian; delays are float32 nanoseconds, with +inf where a slack is unconstrained and NaN where an arrival or
+required time was never set (e.g. a port that no path from a startpoint reaches). Each table is a uint32 row count
+followed by its columns, each stored as one contiguous array. Required times are relative to the capturing clock edge,
+not including the period. python/timing_db.py is a reader for this format.
+
+    header:       char[8] "NPNRTDB\0", uint32 version
+    strings:      count; per string: uint32 length, bytes (not terminated). Index 0 is the empty string
+    domains:      count; int32 clock (string), uint8 edge (0 = rising, 1 = falling)
+    domain pairs: count; int32 launch, int32 capture, float32 period, float32 worst setup slack,
+                  float32 worst hold slack
+    ports:        count; int32 cell (string), int32 port (string), uint8 type (0 = in, 1 = out, 2 = inout),
+                  float32 worst setup slack, float32 worst hold slack, float32 criticality,
+                  then int32[count + 1] offsets into each of the arrival, required and port pair tables
+    edges:        count; int32 from port, int32 to port, uint8 routing, float32 min delay, float32 max delay
+    arrival:      count; int32 domain, float32 min, float32 max
+    required:     count; int32 domain, float32 min, float32 max
+    port pairs:   count; int32 domain pair, float32 setup slack, float32 hold slack, float32 criticality
+*/
+
+namespace {
+const char timing_db_magic[8] = {'N', 'P', 'N', 'R', 'T', 'D', 'B', '\0'};
+const uint32_t timing_db_version = 1;
+
+struct TimingDbWriter
+{
+    std::ostream &out;
+    TimingDbWriter(std::ostream &out) : out(out){};
+
+    void write_u32(uint32_t value)
+    {
+        uint8_t buf[4];
+        for (int i = 0; i < 4; i++)
+            buf[i] = uint8_t(value >> (8 * i));
+        out.write(reinterpret_cast<const char *>(buf), 4);
+    }
+
+    void write_column(const std::vector<int32_t> &col)
+    {
+        for (int32_t value : col)
+            write_u32(uint32_t(value));
+    }
+
+    void write_column(const std::vector<uint8_t> &col)
+    {
+        out.write(reinterpret_cast<const char *>(col.data()), col.size());
+    }
+
+    void write_column(const std::vector<float> &col)
+    {
+        static_assert(sizeof(float) == sizeof(uint32_t), "float must be 32-bit");
+        for (float value : col) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            write_u32(bits);
+        }
+    }
+};
+} // namespace
+
+void TimingAnalyser::write_database(std::ostream &out)
+{
+    const float unconstrained = std::numeric_limits<float>::infinity();
+    auto delay_ns = [&](delay_t value) -> float { return ctx->getDelayNS(value); };
+    // Arrival and required times that were never set still hold the init_delay sentinels, which would otherwise read as
+    // huge real times
+    auto time_ns = [&](delay_t value) -> float {
+        if (value == init_delay.min_delay || value == init_delay.max_delay)
+            return std::numeric_limits<float>::quiet_NaN();
+        return ctx->getDelayNS(value);
+    };
+    auto slack_ns = [&](delay_t value) -> float {
+        return (value == std::numeric_limits<delay_t>::max()) ? unconstrained : ctx->getDelayNS(value);
+    };
+    // Per domain pair setup slacks are held relative to the period internally; export them as absolute slacks, like the
+    // per-port worst slack
+    auto setup_slack_ns = [&](domain_id_t pair, delay_t value) -> float {
+        if (value == std::numeric_limits<delay_t>::max())
+            return unconstrained;
+        return ctx->getDelayNS(domain_pairs.at(pair).period.minDelay() + value);
+    };
+
+    std::vector<IdString> strings;
+    dict<IdString, int> string_index;
+    auto get_string = [&](IdString str) -> int32_t {
+        auto fnd = string_index.find(str);
+        if (fnd != string_index.end())
+            return fnd->second;
+        int idx = int(strings.size());
+        strings.push_back(str);
+        string_index.emplace(str, idx);
+        return idx;
+    };
+    get_string(IdString());
+
+    TimingDbWriter w(out);
+    out.write(timing_db_magic, sizeof(timing_db_magic));
+    w.write_u32(timing_db_version);
+
+    // Build all the columns first, so the complete string table can be written ahead of them
+    std::vector<int32_t> dom_clock;
+    std::vector<uint8_t> dom_edge;
+    for (auto &dom : domains) {
+        dom_clock.push_back(get_string(dom.key.clock));
+        dom_edge.push_back(uint8_t(dom.key.edge));
+    }
+
+    std::vector<int32_t> dp_launch, dp_capture;
+    std::vector<float> dp_period, dp_setup, dp_hold;
+    for (domain_id_t i = 0; i < domain_id_t(domain_pairs.size()); i++) {
+        auto &dp = domain_pairs.at(i);
+        dp_launch.push_back(dp.key.launch);
+        dp_capture.push_back(dp.key.capture);
+        dp_period.push_back(delay_ns(dp.period.min_delay));
+        dp_setup.push_back(setup_slack_ns(i, dp.worst_setup_slack));
+        dp_hold.push_back(slack_ns(dp.worst_hold_slack));
+    }
+
+    std::vector<int32_t> port_cell, port_name, arr_offset, req_offset, pair_offset;
+    std::vector<uint8_t> port_type;
+    std::vector<float> port_setup, port_hold, port_crit;
+    std::vector<int32_t> arr_domain, req_domain;
+    std::vector<float> arr_min, arr_max, req_min, req_max;
+    std::vector<int32_t> pp_pair;
+    std::vector<float> pp_setup, pp_hold, pp_crit;
+    // Re-pack the per-port ranges, as the in-memory arrays may contain gaps
+    for (auto &pd : ports) {
+        port_cell.push_back(get_string(pd.cell_port.cell));
+        port_name.push_back(get_string(pd.cell_port.port));
+        port_type.push_back(uint8_t(pd.type));
+        port_setup.push_back(slack_ns(pd.worst_setup_slack));
+        port_hold.push_back(slack_ns(pd.worst_hold_slack));
+        port_crit.push_back(pd.worst_crit);
+        arr_offset.push_back(int32_t(arr_domain.size()));
+        for (int i = pd.arrival_begin; i < pd.arrival_end; i++) {
+            arr_domain.push_back(arrival.at(i).domain);
+            arr_min.push_back(time_ns(arrival.at(i).value.min_delay));
+            arr_max.push_back(time_ns(arrival.at(i).value.max_delay));
+        }
+        req_offset.push_back(int32_t(req_domain.size()));
+        for (int i = pd.required_begin; i < pd.required_end; i++) {
+            req_domain.push_back(required.at(i).domain);
+            req_min.push_back(time_ns(required.at(i).value.min_delay));
+            req_max.push_back(time_ns(required.at(i).value.max_delay));
+        }
+        pair_offset.push_back(int32_t(pp_pair.size()));
+        for (int i = pd.pairs_begin; i < pd.pairs_end; i++) {
+            auto &pp = port_pairs.at(i);
+            pp_pair.push_back(pp.pair);
+            pp_setup.push_back(setup_slack_ns(pp.pair, pp.setup_slack));
+            pp_hold.push_back(slack_ns(pp.hold_slack));
+            pp_crit.push_back(pp.criticality);
+        }
+    }
+    arr_offset.push_back(int32_t(arr_domain.size()));
+    req_offset.push_back(int32_t(req_domain.size()));
+    pair_offset.push_back(int32_t(pp_pair.size()));
+
+    std::vector<int32_t> edge_from, edge_to;
+    std::vector<uint8_t> edge_routing;
+    std::vector<float> edge_min, edge_max;
+    for (auto &edge : edges) {
+        DelayPair delay = edge.routing ? ports.at(edge.to).route_delay : edge.delay;
+        edge_from.push_back(edge.from);
+        edge_to.push_back(edge.to);
+        edge_routing.push_back(edge.routing ? 1 : 0);
+        edge_min.push_back(delay_ns(delay.min_delay));
+        edge_max.push_back(delay_ns(delay.max_delay));
+    }
+
+    w.write_u32(uint32_t(strings.size()));
+    for (IdString str : strings) {
+        const std::string &s = str.str(ctx);
+        w.write_u32(uint32_t(s.size()));
+        out.write(s.data(), s.size());
+    }
+
+    w.write_u32(uint32_t(domains.size()));
+    w.write_column(dom_clock);
+    w.write_column(dom_edge);
+
+    w.write_u32(uint32_t(domain_pairs.size()));
+    w.write_column(dp_launch);
+    w.write_column(dp_capture);
+    w.write_column(dp_period);
+    w.write_column(dp_setup);
+    w.write_column(dp_hold);
+
+    w.write_u32(uint32_t(ports.size()));
+    w.write_column(port_cell);
+    w.write_column(port_name);
+    w.write_column(port_type);
+    w.write_column(port_setup);
+    w.write_column(port_hold);
+    w.write_column(port_crit);
+    w.write_column(arr_offset);
+    w.write_column(req_offset);
+    w.write_column(pair_offset);
+
+    w.write_u32(uint32_t(edges.size()));
+    w.write_column(edge_from);
+    w.write_column(edge_to);
+    w.write_column(edge_routing);
+    w.write_column(edge_min);
+    w.write_column(edge_max);
+
+    w.write_u32(uint32_t(arr_domain.size()));
+    w.write_column(arr_domain);
+    w.write_column(arr_min);
+    w.write_column(arr_max);
+
+    w.write_u32(uint32_t(req_domain.size()));
+    w.write_column(req_domain);
+    w.write_column(req_min);
+    w.write_column(req_max);
+
+    w.write_u32(uint32_t(pp_pair.size()));
+    w.write_column(pp_pair);
+    w.write_column(pp_setup);
+    w.write_column(pp_hold);
+    w.write_column(pp_crit);
+}
+
+void Context::writeTimingDatabase(std::ostream &out)
+{
+    TimingAnalyser tmg(getCtx());
+    tmg.setup();
+    tmg.write_database(out);
+}
+
+NEXTPNR_NAMESPACE_END
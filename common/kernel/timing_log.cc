@@ -39,7 +39,7 @@ static std::string clock_event_name(const Context *ctx, const ClockEvent &e, int
 
 static void log_crit_paths(const Context *ctx, TimingResult &result)
 {
-    static auto print_net_source = [ctx](const NetInfo *net) {
+    auto print_net_source = [ctx](const NetInfo *net) {
         // Check if this net is annotated with a source list
         auto sources = net->attrs.find(ctx->id("src"));
         if (sources == net->attrs.end()) {
@@ -67,7 +67,7 @@ static void log_crit_paths(const Context *ctx, TimingResult &result)
     };
 
     // A helper function for reporting one critical path
-    auto print_path_report = [ctx](const CriticalPath &path) {
+    auto print_path_report = [ctx, &print_net_source](const CriticalPath &path) {
         delay_t total = 0, logic_total = 0, route_total = 0;
 
         log_info("curr total\n");
@@ -158,6 +158,19 @@ static void log_crit_paths(const Context *ctx, TimingResult &result)
         log_info("Critical path report for cross-domain path '%s' -> '%s':\n", start.c_str(), end.c_str());
         print_path_report(report);
     }
+
+    // Next worst paths, numbered from 2 within each clock pair
+    dict<std::pair<std::string, std::string>, int> ranks;
+    for (auto &report : result.near_critical_paths) {
+        log_break();
+        std::string start = clock_event_name(ctx, report.clock_pair.start);
+        std::string end = clock_event_name(ctx, report.clock_pair.end);
+        int &rank = ranks[std::make_pair(start, end)];
+        if (rank == 0)
+            rank = 1;
+        log_info("Path #%d report for '%s' -> '%s':\n", ++rank, start.c_str(), end.c_str());
+        print_path_report(report);
+    }
 };
 
 static void log_fmax(Context *ctx, TimingResult &result, bool warn_on_failure)
@@ -356,6 +369,21 @@ static void log_histogram(Context *ctx, TimingResult &result)
                  (bins[i] * bar_width) % max_freq > 0 ? '+' : ' ');
 }
 
+static void log_corners(Context *ctx, TimingResult &result)
+{
+    for (auto &corner : result.corners) {
+        for (auto &clock : corner.second.clock_fmax) {
+            float fmax = clock.second.achieved;
+            float target = clock.second.constraint;
+            log_info("Corner '%s': max frequency for clock '%s': %.02f MHz (%s at %.02f MHz), worst hold slack %.02f "
+                     "ns\n",
+                     corner.first.c_str(ctx), clock.first.c_str(ctx), fmax, target < fmax ? "PASS" : "FAIL", target,
+                     ctx->getDelayNS(corner.second.clock_hold_slack.at(clock.first)));
+        }
+    }
+    log_break();
+}
+
 void Context::log_timing_results(TimingResult &result, bool print_histogram, bool print_fmax, bool print_path,
                                  bool warn_on_failure)
 {
@@ -365,6 +393,9 @@ void Context::log_timing_results(TimingResult &result, bool print_histogram, boo
     if (print_fmax)
         log_fmax(this, result, warn_on_failure);
 
+    if (print_fmax && !result.corners.empty())
+        log_corners(this, result);
+
     if (print_histogram && !result.slack_histogram.empty())
         log_histogram(this, result);
 }
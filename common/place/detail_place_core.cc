@@ -48,13 +48,23 @@ PlacePartition::PlacePartition(Context *ctx)
     }
 }
 
-void PlacePartition::split(Context *ctx, bool yaxis, float pivot, PlacePartition &l, PlacePartition &r)
+void PlacePartition::split(Context *ctx, bool yaxis, float pivot, PlacePartition &l, PlacePartition &r,
+                           const std::function<float(const CellInfo *)> &weight)
 {
     std::sort(cells.begin(), cells.end(), [&](CellInfo *a, CellInfo *b) {
         Loc l0 = ctx->getBelLocation(a->bel), l1 = ctx->getBelLocation(b->bel);
         return yaxis ? (l0.y < l1.y) : (l0.x < l1.x);
     });
     size_t pivot_point = size_t(cells.size() * pivot);
+    if (weight) {
+        double total_weight = 0;
+        for (auto cell : cells)
+            total_weight += weight(cell);
+        double target = total_weight * pivot, cumulative = 0;
+        pivot_point = 0;
+        while (pivot_point < cells.size() && cumulative < target)
+            cumulative += weight(cells.at(pivot_point++));
+    }
     l.cells.clear();
     r.cells.clear();
     l.cells.reserve(pivot_point);
@@ -199,6 +209,7 @@ void DetailPlacerThreadState::setup_initial_state()
         arc_tmg_cost.push_back(g.last_tmg_costs.at(tn->udata));
     }
     new_net_bounds = net_bounds;
+    setup_net_hists();
     for (int j = 0; j < 2; j++) {
         auto &a = axes.at(j);
         a.already_bounds_changed.resize(net_bounds.size());
@@ -209,6 +220,32 @@ void DetailPlacerThreadState::setup_initial_state()
         already_timing_changed.at(i) = std::vector<bool>(thread_nets.at(i)->users.capacity());
 }
 
+void DetailPlacerThreadState::setup_net_hists()
+{
+    net_hist_idx.assign(thread_nets.size(), -1);
+    hist_changes.clear();
+    int hist_count = 0;
+    auto cell_loc = [&](const CellInfo *cell) {
+        if (cell->isPseudo())
+            return cell->getLocation();
+        return ctx->getBelLocation(local_cell2bel.at(cell->name));
+    };
+    for (size_t i = 0; i < thread_nets.size(); i++) {
+        const NetInfo *net = thread_nets.at(i);
+        if (ignored_nets.at(i) || int(net->users.entries()) < PinHistogram::min_fanout)
+            continue;
+        net_hist_idx.at(i) = hist_count;
+        if (hist_count >= int(net_hists.size()))
+            net_hists.emplace_back();
+        auto &hist = net_hists.at(hist_count++);
+        hist.init(ctx->getGridDimX(), ctx->getGridDimY());
+        hist.add(cell_loc(net->driver.cell));
+        for (auto &usr : net->users)
+            hist.add(cell_loc(usr.cell));
+    }
+    net_hists.resize(hist_count);
+}
+
 bool DetailPlacerThreadState::bounds_check(BelId bel)
 {
     Loc l = ctx->getBelLocation(bel);
@@ -217,10 +254,10 @@ bool DetailPlacerThreadState::bounds_check(BelId bel)
     return true;
 }
 
-bool DetailPlacerThreadState::bind_move()
+bool DetailPlacerThreadState::apply_move()
 {
 #if !defined(NPNR_DISABLE_THREADS)
-    std::unique_lock<std::shared_timed_mutex> l(g.archapi_mutex);
+    std::unique_lock<std::mutex> l(g.archapi_mutex);
 #endif
     for (auto &entry : moved_cells) {
         ctx->unbindBel(entry.second.first);
@@ -234,38 +271,18 @@ bool DetailPlacerThreadState::bind_move()
         }
         ctx->bindBel(entry.second.second, ctx->cells.at(entry.first).get(), STRENGTH_WEAK);
     }
-    arch_state_dirty = true;
-    return success;
-}
-
-bool DetailPlacerThreadState::check_validity()
-{
-#if !defined(NPNR_DISABLE_THREADS)
-    std::shared_lock<std::shared_timed_mutex> l(g.archapi_mutex);
-#endif
-    bool result = true;
-    for (auto e : moved_cells) {
-        if (!ctx->isBelLocationValid(e.second.first)) {
+    if (success) {
+        for (auto &entry : moved_cells) {
             // Have to check old; too; as unbinding a bel could make a placement illegal by virtue of no longer
             // enabling dedicated routes to be used
-            result = false;
-            break;
-        }
-        if (!ctx->isBelLocationValid(e.second.second)) {
-            result = false;
-            break;
+            if (!ctx->isBelLocationValid(entry.second.first) || !ctx->isBelLocationValid(entry.second.second)) {
+                success = false;
+                break;
+            }
         }
     }
-    return result;
-}
-
-void DetailPlacerThreadState::revert_move()
-{
-    if (arch_state_dirty) {
-        // If changes to the arch state were made, revert them by restoring original cell bindings
-#if !defined(NPNR_DISABLE_THREADS)
-        std::unique_lock<std::shared_timed_mutex> l(g.archapi_mutex);
-#endif
+    if (!success) {
+        // Restore the original bindings before anyone else can observe the failed move
         for (auto &entry : moved_cells) {
             BelId curr_bound = ctx->cells.at(entry.first)->bel;
             if (curr_bound != BelId())
@@ -274,15 +291,19 @@ void DetailPlacerThreadState::revert_move()
         for (auto &entry : moved_cells) {
             ctx->bindBel(entry.second.first, ctx->cells.at(entry.first).get(), STRENGTH_WEAK);
         }
-        arch_state_dirty = false;
     }
+    return success;
+}
+
+void DetailPlacerThreadState::revert_move()
+{
     for (auto &entry : moved_cells)
         local_cell2bel[entry.first] = entry.second.first;
 }
 
 void DetailPlacerThreadState::commit_move()
 {
-    arch_state_dirty = false;
+    hist_changes.clear();
     for (auto &axis : axes) {
         for (auto bc : axis.bounds_changed_nets) {
             // Commit updated net bounds
@@ -309,6 +330,10 @@ void DetailPlacerThreadState::compute_changes_for_cell(CellInfo *cell, BelId old
         int idx = thread_net_idx.at(pn->udata);
         if (ignored_nets.at(idx))
             continue;
+        if (net_hist_idx.at(idx) != -1) {
+            net_hists.at(net_hist_idx.at(idx)).move(old_loc, new_loc);
+            hist_changes.emplace_back(idx, old_loc, new_loc);
+        }
         NetBB &new_bounds = new_net_bounds.at(idx);
         // For the x-axis (i=0) and y-axis (i=1)
         for (int i = 0; i < 2; i++) {
@@ -406,12 +431,18 @@ void DetailPlacerThreadState::compute_changes_for_cell(CellInfo *cell, BelId old
 void DetailPlacerThreadState::compute_total_change()
 {
     auto &xa = axes.at(0), &ya = axes.at(1);
+    auto recompute_bounds = [&](int net) {
+        if (net_hist_idx.at(net) != -1)
+            net_hists.at(net_hist_idx.at(net)).get_bounds(new_net_bounds.at(net));
+        else
+            new_net_bounds.at(net) = NetBB::compute(ctx, thread_nets.at(net), &local_cell2bel);
+    };
     for (auto &bc : xa.bounds_changed_nets)
         if (xa.already_bounds_changed.at(bc) == FULL_RECOMPUTE)
-            new_net_bounds.at(bc) = NetBB::compute(ctx, thread_nets.at(bc), &local_cell2bel);
+            recompute_bounds(bc);
     for (auto &bc : ya.bounds_changed_nets)
         if (xa.already_bounds_changed.at(bc) != FULL_RECOMPUTE && ya.already_bounds_changed.at(bc) == FULL_RECOMPUTE)
-            new_net_bounds.at(bc) = NetBB::compute(ctx, thread_nets.at(bc), &local_cell2bel);
+            recompute_bounds(bc);
     for (auto &bc : xa.bounds_changed_nets)
         wirelen_delta += (new_net_bounds.at(bc).hpwl(g.base_cfg) - net_bounds.at(bc).hpwl(g.base_cfg));
     for (auto &bc : ya.bounds_changed_nets)
@@ -441,6 +472,9 @@ void DetailPlacerThreadState::reset_move_state()
     for (auto &arc : timing_changed_arcs) {
         already_timing_changed.at(arc.first).at(arc.second.idx()) = false;
     }
+    for (auto hc = hist_changes.rbegin(); hc != hist_changes.rend(); ++hc)
+        net_hists.at(net_hist_idx.at(std::get<0>(*hc))).move(std::get<2>(*hc), std::get<1>(*hc));
+    hist_changes.clear();
     timing_changed_arcs.clear();
     new_timing_costs.clear();
     wirelen_delta = 0;
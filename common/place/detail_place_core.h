@@ -33,9 +33,10 @@ per-move structures; then to add all of the moved cells to the move with add_to_
 
 Evaluation of wirelength and timing changes of a move is done with compute_changes_for_cell and compute_total_change.
 
-bind_move will probationally bind the move using the arch API functions, acquiring a lock during this time to prevent
-races on non-thread-safe arch implementations, returning true if the bind succeeded or false if something went wrong
-and it should be aborted. check_validity must then be called to use the arch API validity check functions on the move.
+apply_move will probationally bind the move using the arch API functions and check the validity of the affected bels,
+all inside one short exclusive section to prevent races on non-thread-safe arch implementations. It returns true if the
+move was bound and is legal; otherwise the original bindings are restored before the lock is released and the move
+should be aborted.
 
 Finally if the move meets criteria and is accepted then commit_move marks it as committed, otherwise revert_move
 aborts the entire move transaction.
@@ -48,12 +49,14 @@ aborts the entire move transaction.
 
 #include "detail_place_cfg.h"
 #include "fast_bels.h"
+#include "pin_histogram.h"
 #include "timing.h"
 
+#include <functional>
 #include <queue>
 
 #if !defined(NPNR_DISABLE_THREADS)
-#include <shared_mutex>
+#include <mutex>
 #endif
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -64,7 +67,10 @@ struct PlacePartition
     std::vector<CellInfo *> cells;
     PlacePartition() = default;
     explicit PlacePartition(Context *ctx);
-    void split(Context *ctx, bool yaxis, float pivot, PlacePartition &l, PlacePartition &r);
+    // Split along an axis so that the left/bottom half receives the given fraction of the cells; or of the total
+    // weight of the cells if a weight function is provided
+    void split(Context *ctx, bool yaxis, float pivot, PlacePartition &l, PlacePartition &r,
+               const std::function<float(const CellInfo *)> &weight = {});
 };
 
 typedef int64_t wirelen_t;
@@ -99,7 +105,7 @@ struct DetailPlacerState
     double total_timing_cost = 0;
 
 #if !defined(NPNR_DISABLE_THREADS)
-    std::shared_timed_mutex archapi_mutex;
+    std::mutex archapi_mutex;
 #endif
 
     inline double get_timing_cost(const NetInfo *net, store_index<PortRef> user,
@@ -165,7 +171,6 @@ struct DetailPlacerThreadState
     std::vector<NetBB> net_bounds;
     std::vector<std::vector<double>> arc_tmg_cost;
     std::vector<bool> ignored_nets, tmg_ignored_nets;
-    bool arch_state_dirty = false;
     // Our local cell-bel map; that won't be affected by out-of-partition moves
     dict<IdString, BelId> local_cell2bel;
 
@@ -191,6 +196,11 @@ struct DetailPlacerThreadState
     };
     std::array<AxisChanges, 2> axes;
     std::vector<NetBB> new_net_bounds;
+    // Pin location histograms for high-fanout nets, so full bounding box recomputes don't need to scan all pins;
+    // and the pin moves applied to them by the inflight move, to be undone unless it is committed
+    std::vector<int> net_hist_idx;
+    std::vector<PinHistogram> net_hists;
+    std::vector<std::tuple<int, Loc, Loc>> hist_changes;
 
     std::vector<std::vector<bool>> already_timing_changed;
     std::vector<std::pair<int, store_index<PortRef>>> timing_changed_arcs;
@@ -199,16 +209,15 @@ struct DetailPlacerThreadState
     DetailPlacerThreadState(Context *ctx, DetailPlacerState &g, int idx) : ctx(ctx), g(g), idx(idx){};
     void set_partition(const PlacePartition &part);
     void setup_initial_state();
+    void setup_net_hists();
     bool bounds_check(BelId bel);
 
     // Reset the inflight move state
     void reset_move_state();
     // Add a cell change to the move
     bool add_to_move(CellInfo *cell, BelId old_bel, BelId new_bel);
-    // For an inflight move; attempt to actually apply the changes to the arch API
-    bool bind_move();
-    // Checks if the arch API bel validity for a move is accepted
-    bool check_validity();
+    // For an inflight move; attempt to actually apply the changes to the arch API and check they are legal
+    bool apply_move();
     // Undo any changes relating to an inflight move
     void revert_move();
     // Mark the inflight move as complete and update cost structures
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include "nextpnr.h"
 
@@ -89,6 +90,9 @@ struct FastBels
 
             bel_data->at(loc.x).at(loc.y).push_back(bel);
         }
+
+        index_by_cell_type.resize(type_idx + 1);
+        index_by_cell_type.at(type_idx).build(*bel_data);
     }
 
     void addBelBucket(BelBucketId partition)
@@ -140,11 +144,85 @@ struct FastBels
 
             bel_data->at(loc.x).at(loc.y).push_back(bel);
         }
+
+        index_by_partition_type.resize(type_idx + 1);
+        index_by_partition_type.at(type_idx).build(*bel_data);
     }
 
     typedef std::vector<std::vector<std::vector<BelId>>> FastBelsData;
 
-    int getBelsForCellType(IdString cell_type, FastBelsData **data)
+    // FastBelsIndex is a 2D prefix count over the grid locations of a FastBelsData that contain at least one bel.
+    // The number of such locations inside a window is found in O(1), and the k-th of them by two binary searches,
+    // so that placers can pick a uniformly random non-empty location in range without rejection sampling.
+    struct FastBelsIndex
+    {
+        int width = 0, height = 0;
+        // Number of non-empty locations in [0, x) * [0, y), stored at x * (height + 1) + y
+        std::vector<int> prefix;
+
+        void build(const FastBelsData &data)
+        {
+            width = int(data.size());
+            height = 0;
+            for (const auto &col : data)
+                height = std::max(height, int(col.size()));
+            prefix.assign((width + 1) * (height + 1), 0);
+            for (int x = 0; x < width; x++) {
+                int col_count = 0;
+                for (int y = 0; y < height; y++) {
+                    if (y < int(data.at(x).size()) && !data.at(x).at(y).empty())
+                        ++col_count;
+                    prefix.at((x + 1) * (height + 1) + (y + 1)) = prefix.at(x * (height + 1) + (y + 1)) + col_count;
+                }
+            }
+        }
+
+        // Number of non-empty locations in the inclusive window [x0, x1] * [y0, y1], clipped to the grid
+        int count(int x0, int y0, int x1, int y1) const
+        {
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, width - 1);
+            y1 = std::min(y1, height - 1);
+            if (x0 > x1 || y0 > y1)
+                return 0;
+            auto p = [&](int x, int y) { return prefix[x * (height + 1) + y]; };
+            return p(x1 + 1, y1 + 1) - p(x0, y1 + 1) - p(x1 + 1, y0) + p(x0, y0);
+        }
+
+        // Find the k-th (in column-major order) non-empty location in a window; k must be less than the count
+        Loc get(int x0, int y0, int x1, int y1, int k) const
+        {
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, width - 1);
+            y1 = std::min(y1, height - 1);
+            // Smallest column such that the window up to and including it has more than k locations
+            int lo = x0, hi = x1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (count(x0, y0, mid, y1) > k)
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+            int x = lo;
+            if (x > x0)
+                k -= count(x0, y0, x - 1, y1);
+            // Then the smallest row inside that column
+            lo = y0, hi = y1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (count(x, y0, x, mid) > k)
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+            return Loc(x, lo, 0);
+        }
+    };
+
+    int getBelsForCellType(IdString cell_type, FastBelsData **data, const FastBelsIndex **index = nullptr)
     {
         auto iter = cell_types.find(cell_type);
         if (iter == cell_types.end()) {
@@ -156,10 +234,12 @@ struct FastBels
         auto cell_type_data = iter->second;
 
         *data = fast_bels_by_cell_type.at(cell_type_data.type_index).get();
+        if (index != nullptr)
+            *index = &index_by_cell_type.at(cell_type_data.type_index);
         return cell_type_data.number_of_possible_bels;
     }
 
-    size_t getBelsForBelBucket(BelBucketId partition, FastBelsData **data)
+    size_t getBelsForBelBucket(BelBucketId partition, FastBelsData **data, const FastBelsIndex **index = nullptr)
     {
         auto iter = partition_types.find(partition);
         if (iter == partition_types.end()) {
@@ -171,6 +251,8 @@ struct FastBels
         auto type_data = iter->second;
 
         *data = fast_bels_by_partition_type.at(type_data.type_index).get();
+        if (index != nullptr)
+            *index = &index_by_partition_type.at(type_data.type_index);
         return type_data.number_of_possible_bels;
     }
 
@@ -180,9 +262,11 @@ struct FastBels
 
     dict<IdString, TypeData> cell_types;
     std::vector<std::unique_ptr<FastBelsData>> fast_bels_by_cell_type;
+    std::vector<FastBelsIndex> index_by_cell_type;
 
     dict<BelBucketId, TypeData> partition_types;
     std::vector<std::unique_ptr<FastBelsData>> fast_bels_by_partition_type;
+    std::vector<FastBelsIndex> index_by_partition_type;
 };
 
 NEXTPNR_NAMESPACE_END
@@ -22,14 +22,16 @@
 
 #if !defined(NPNR_DISABLE_THREADS)
 
+#include "array2d.h"
 #include "detail_place_core.h"
+#include "profiler.h"
 #include "scope_lock.h"
+#include "thread_pool.h"
+#include "util.h"
 
 #include <chrono>
-#include <mutex>
+#include <functional>
 #include <queue>
-#include <shared_mutex>
-#include <thread>
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -53,9 +55,21 @@ struct ThreadState : DetailPlacerThreadState
     // Total made and accepted moved
     GlobalState &g;
     int n_move = 0, n_accept = 0;
+    // Work done by the last refinement pass, used to rebalance partitions: the cells, nets and timing arcs evaluated
+    // by its moves. Counted rather than timed, so that the partitioning, and so the result, doesn't depend on how fast
+    // each thread happens to run
+    int64_t iter_work = 0;
 
     dict<std::pair<int, int>, std::vector<CellInfo *>> tile2cell;
 
+    // Evaluate the cost change of the inflight move, counting the work done
+    void evaluate_move()
+    {
+        compute_total_change();
+        iter_work += int64_t(moved_cells.size()) + int64_t(axes.at(0).bounds_changed_nets.size()) +
+                     int64_t(axes.at(1).bounds_changed_nets.size()) + int64_t(timing_changed_arcs.size());
+    }
+
     bool accept_move()
     {
         static constexpr double epsilon = 1e-20;
@@ -76,7 +90,7 @@ struct ThreadState : DetailPlacerThreadState
             goto fail;
         if (bound && !add_to_move(bound, new_bel, old_bel))
             goto fail;
-        compute_total_change();
+        evaluate_move();
         // SA acceptance criteria
 
         if (!accept_move()) {
@@ -84,9 +98,7 @@ struct ThreadState : DetailPlacerThreadState
             goto fail;
         }
         // Check validity rules
-        if (!bind_move())
-            goto fail;
-        if (!check_validity())
+        if (!apply_move())
             goto fail;
         // Accepted!
         commit_move();
@@ -151,7 +163,7 @@ struct ThreadState : DetailPlacerThreadState
                 }
             }
         }
-        compute_total_change();
+        evaluate_move();
         // SA acceptance criteria
 
         if (!accept_move()) {
@@ -159,9 +171,7 @@ struct ThreadState : DetailPlacerThreadState
             goto fail;
         }
         // Check validity rules
-        if (!bind_move())
-            goto fail;
-        if (!check_validity())
+        if (!apply_move())
             goto fail;
         // Accepted!
         commit_move();
@@ -193,20 +203,27 @@ struct ThreadState : DetailPlacerThreadState
         }
 
         FastBels::FastBelsData *bel_data;
-        auto type_cnt = g.bels.getBelsForCellType(targetType, &bel_data);
+        const FastBels::FastBelsIndex *bel_index;
+        auto type_cnt = g.bels.getBelsForCellType(targetType, &bel_data, &bel_index);
+
+        int x0 = std::max(curr_loc.x - dx, 0), y0 = std::max(curr_loc.y - dy, 0);
+        int x1 = x0 + 2 * dx, y1 = y0 + 2 * dy;
+        if (type_cnt < 64) {
+            x0 = y0 = x1 = y1 = 0;
+        } else {
+            // Only consider locations inside our partition
+            x0 = std::max(x0, p.x0);
+            y0 = std::max(y0, p.y0);
+            x1 = std::min(x1, p.x1);
+            y1 = std::min(y1, p.y1);
+        }
+        int loc_count = bel_index->count(x0, y0, x1, y1);
+        if (loc_count == 0)
+            return BelId();
 
         while (true) {
-            int nx = rng.rng(2 * dx + 1) + std::max(curr_loc.x - dx, 0);
-            int ny = rng.rng(2 * dy + 1) + std::max(curr_loc.y - dy, 0);
-            if (type_cnt < 64)
-                nx = ny = 0;
-            if (nx >= int(bel_data->size()))
-                continue;
-            if (ny >= int(bel_data->at(nx).size()))
-                continue;
-            const auto &fb = bel_data->at(nx).at(ny);
-            if (fb.size() == 0)
-                continue;
+            Loc nl = bel_index->get(x0, y0, x1, y1, rng.rng(loc_count));
+            const auto &fb = bel_data->at(nl.x).at(nl.y);
             BelId bel = fb.at(rng.rng(int(fb.size())));
             if (!bounds_check(bel))
                 continue;
@@ -267,16 +284,14 @@ struct ThreadState : DetailPlacerThreadState
         if (!move_tile(xn, yn, x, y))
             goto fail;
 
-        compute_total_change();
+        evaluate_move();
         // SA acceptance criteria
         if (!accept_move()) {
             // SA fail
             goto fail;
         }
         // Check validity rules
-        if (!bind_move())
-            goto fail;
-        if (!check_validity())
+        if (!apply_move())
             goto fail;
         // Accepted!
         commit_move();
@@ -304,8 +319,8 @@ struct ThreadState : DetailPlacerThreadState
             int x = t.first, y = t.second;
             int lx = std::max(x - g.radius, p.x0), rx = std::min(x + g.radius, p.x1);
             int by = std::max(y - g.radius, p.y0), ty = std::min(y + g.radius, p.y1);
-            int xn = lx + ctx->rng((rx - lx) + 1);
-            int yn = by + ctx->rng((ty - by) + 1);
+            int xn = lx + rng.rng((rx - lx) + 1);
+            int yn = by + rng.rng((ty - by) + 1);
             ++n_move;
             if (do_tile_swap(x, y, xn, yn)) {
                 ++n_accept;
@@ -318,6 +333,7 @@ struct ThreadState : DetailPlacerThreadState
         setup_initial_state();
         n_accept = 0;
         n_move = 0;
+        iter_work = 0;
         for (int m = 0; m < g.cfg.inner_iters; m++) {
             for (auto cell : p.cells) {
                 if (cell->belStrength > STRENGTH_STRONG)
@@ -352,6 +368,10 @@ struct ParallelRefine
     Context *ctx;
     GlobalState g;
     std::vector<ThreadState> t;
+    // The Context's shared worker threads, kept alive across iterations, asked for with one per partition. cfg.threads
+    // sets the number of partitions rather than the number of threads running them, so results don't depend on the
+    // size of the pool
+    ThreadPool *workers = nullptr;
     ParallelRefine(Context *ctx, ParallelRefineCfg cfg) : ctx(ctx), g(ctx, cfg)
     {
         g.flat_nets.reserve(ctx->nets.size());
@@ -401,33 +421,106 @@ struct ParallelRefine
         for (auto cell_type : cell_types_in_use) {
             g.bels.addCellType(cell_type);
         }
+        tile_cost.reset(ctx->getGridDimX(), ctx->getGridDimY(), 1.0f);
     };
+
+    // Per-tile correction to the estimated work of cells, learnt from how much work each partition actually took
+    array2d<float> tile_cost;
+
+    // Estimated cost of refining a cell: movable cells scaled by their connectivity
+    float cell_weight(const CellInfo *cell) const
+    {
+        if (cell->belStrength > STRENGTH_STRONG)
+            return 0.1f;
+        int conns = 0;
+        for (auto &port : cell->ports)
+            if (port.second.net)
+                ++conns;
+        Loc loc = ctx->getBelLocation(cell->bel);
+        return (1 + conns) * tile_cost.at(loc.x, loc.y);
+    }
+
+    float partition_weight(const PlacePartition &part) const
+    {
+        float weight = 0;
+        for (auto cell : part.cells)
+            weight += cell_weight(cell);
+        return weight;
+    }
+
+    // Nudge the tile costs of each partition towards its counted work per unit of estimated work, so the next
+    // partitioning gives busier regions fewer cells
+    void update_tile_costs()
+    {
+        std::vector<float> part_weight(parts.size());
+        float total_work = 0, total_weight = 0;
+        for (size_t i = 0; i < parts.size(); i++) {
+            part_weight.at(i) = partition_weight(parts.at(i));
+            total_work += float(t.at(i).iter_work);
+            total_weight += part_weight.at(i);
+        }
+        if (total_work <= 0 || total_weight <= 0)
+            return;
+        float mean_cost = total_work / total_weight;
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (part_weight.at(i) <= 0)
+                continue;
+            // Damped so that the boundaries don't oscillate
+            float ratio = std::sqrt((float(t.at(i).iter_work) / part_weight.at(i)) / mean_cost);
+            auto &p = parts.at(i);
+            for (int y = p.y0; y <= std::min(p.y1, tile_cost.height() - 1); y++)
+                for (int x = p.x0; x <= std::min(p.x1, tile_cost.width() - 1); x++)
+                    tile_cost.at(x, y) = std::min(4.0f, std::max(0.25f, tile_cost.at(x, y) * ratio));
+        }
+    }
+
     std::vector<PlacePartition> parts;
     void do_partition()
     {
+        // k-way recursive bisection: a partition that is to be shared by k threads is split in the ratio
+        // floor(k/2):ceil(k/2) by estimated work, so any thread count is supported
         parts.clear();
         parts.emplace_back(ctx);
+        std::vector<int> part_threads{int(t.size())};
+        auto weight = [this](const CellInfo *cell) { return cell_weight(cell); };
         bool yaxis = false;
         while (parts.size() < t.size()) {
-            std::vector<PlacePartition> next(parts.size() * 2);
+            std::vector<PlacePartition> next;
+            std::vector<int> next_threads;
             for (size_t i = 0; i < parts.size(); i++) {
+                int k = part_threads.at(i);
+                if (k == 1) {
+                    next.push_back(std::move(parts.at(i)));
+                    next_threads.push_back(1);
+                    continue;
+                }
+                int kl = k / 2;
                 // Randomly permute pivot every iteration so we get different thread boundaries
                 const float delta = 0.1;
-                float pivot = (0.5 - (delta / 2)) + (delta / 2) * (ctx->rng(10000) / 10000.0f);
-                parts.at(i).split(ctx, yaxis, pivot, next.at(i * 2), next.at(i * 2 + 1));
+                float pivot = (float(kl) / k - (delta / 2)) + (delta / 2) * (ctx->rng(10000) / 10000.0f);
+                next.emplace_back();
+                next.emplace_back();
+                parts.at(i).split(ctx, yaxis, pivot, next.at(next.size() - 2), next.back(), weight);
+                next_threads.push_back(kl);
+                next_threads.push_back(k - kl);
             }
             std::swap(parts, next);
+            std::swap(part_threads, next_threads);
             yaxis = !yaxis;
         }
 
         NPNR_ASSERT(parts.size() == t.size());
-        // TODO: thread pool to make this worthwhile...
-        std::vector<std::thread> workers;
-        for (size_t i = 0; i < t.size(); i++) {
-            workers.emplace_back([i, this]() { t.at(i).set_partition(parts.at(i)); });
+        run_threads([this](int i) { t.at(i).set_partition(parts.at(i)); });
+    }
+
+    void run_threads(const std::function<void(int)> &func)
+    {
+        if (workers) {
+            workers->run(int(t.size()), func);
+        } else {
+            for (int i = 0; i < int(t.size()); i++)
+                func(i);
         }
-        for (auto &w : workers)
-            w.join();
     }
 
     void run()
@@ -436,10 +529,12 @@ struct ParallelRefine
         ScopeLock<Context> lock(ctx);
         auto refine_start = std::chrono::high_resolution_clock::now();
 
+        workers = ctx->getThreadPool(int(t.size()));
         g.tmg.setup_only = true;
         g.tmg.setup();
         do_partition();
-        log_info("Running parallel refinement with %d threads.\n", int(t.size()));
+        log_info("Running parallel refinement with %d partitions on %d threads.\n", int(t.size()),
+                 workers ? std::min(workers->size(), int(t.size())) : 1);
         int iter = 1;
         bool done = false;
         g.update_global_costs();
@@ -479,14 +574,14 @@ struct ParallelRefine
             if (done)
                 break;
 
+            NPNR_PROFILE_ZONE("refine_iteration");
             do_partition();
 
-            std::vector<std::thread> workers;
-            workers.reserve(t.size());
-            for (int j = 0; j < int(t.size()); j++)
-                workers.emplace_back([this, j]() { t.at(j).run_iter(); });
-            for (auto &w : workers)
-                w.join();
+            run_threads([this](int j) {
+                NPNR_PROFILE_ZONE("refine_partition");
+                t.at(j).run_iter();
+            });
+            update_tile_costs();
             g.tmg.run();
             g.update_global_costs();
             iter++;
@@ -500,12 +595,10 @@ struct ParallelRefine
 
 ParallelRefineCfg::ParallelRefineCfg(Context *ctx) : DetailPlaceCfg(ctx)
 {
-    threads = ctx->setting<int>("threads", 8);
-    // snap to nearest power of two; and minimum thread size
-    int actual_threads = 1;
-    while ((actual_threads * 2) <= threads && (int(ctx->cells.size()) / (actual_threads * 2)) >= min_thread_size)
-        actual_threads *= 2;
-    threads = actual_threads;
+    // Read without storing the default, as "threads" also sizes the Context's shared thread pool
+    threads = int_or_default(ctx->settings, ctx->id("threads"), 8);
+    // enforce a minimum thread size; any thread count is supported by the partitioner
+    threads = std::max(1, std::min(threads, int(ctx->cells.size()) / min_thread_size));
 }
 
 bool parallel_refine(Context *ctx, ParallelRefineCfg cfg)
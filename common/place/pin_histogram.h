@@ -0,0 +1,117 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2026  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PIN_HISTOGRAM_H
+#define PIN_HISTOGRAM_H
+
+#include <array>
+#include <vector>
+
+#include "bits.h"
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// Per-axis counts of the pins of a net at each grid coordinate, along with a bitmap of the occupied coordinates.
+//
+// Incremental bounding box updates only need a full rescan of a net's pins when the last pin on an edge moves
+// inwards. For high-fanout nets, the placers keep one of these instead so that the new edge is found from the
+// bitmap, 32 coordinates at a time, independently of the number of pins.
+struct PinHistogram
+{
+    // Nets with fewer users than this are cheap enough to rescan that a histogram isn't worthwhile
+    static constexpr int min_fanout = 64;
+
+    struct Axis
+    {
+        std::vector<int> count;
+        std::vector<unsigned int> occupied;
+        static constexpr int word_bits = std::numeric_limits<unsigned int>::digits;
+
+        void init(int size)
+        {
+            count.assign(size, 0);
+            occupied.assign((size + word_bits - 1) / word_bits, 0);
+        }
+        void add(int pos)
+        {
+            if (count.at(pos)++ == 0)
+                occupied.at(pos / word_bits) |= (1u << (pos % word_bits));
+        }
+        void remove(int pos)
+        {
+            NPNR_ASSERT(count.at(pos) > 0);
+            if (--count.at(pos) == 0)
+                occupied.at(pos / word_bits) &= ~(1u << (pos % word_bits));
+        }
+        int lowest() const
+        {
+            for (int i = 0; i < int(occupied.size()); i++)
+                if (occupied.at(i) != 0)
+                    return i * word_bits + Bits::ctz(occupied.at(i));
+            NPNR_ASSERT_FALSE("empty pin histogram");
+        }
+        int highest() const
+        {
+            for (int i = int(occupied.size()) - 1; i >= 0; i--)
+                if (occupied.at(i) != 0)
+                    return i * word_bits + (word_bits - 1 - Bits::clz(occupied.at(i)));
+            NPNR_ASSERT_FALSE("empty pin histogram");
+        }
+    };
+    std::array<Axis, 2> axes;
+
+    void init(int width, int height)
+    {
+        axes.at(0).init(width);
+        axes.at(1).init(height);
+    }
+    void add(Loc loc)
+    {
+        axes.at(0).add(loc.x);
+        axes.at(1).add(loc.y);
+    }
+    void remove(Loc loc)
+    {
+        axes.at(0).remove(loc.x);
+        axes.at(1).remove(loc.y);
+    }
+    void move(Loc old_loc, Loc new_loc)
+    {
+        remove(old_loc);
+        add(new_loc);
+    }
+    // Set the edges and edge pin counts of a bounding box type with x0/x1/y0/y1 and nx0/nx1/ny0/ny1 fields
+    template <typename TBox> void get_bounds(TBox &bb) const
+    {
+        const Axis &ax = axes.at(0), &ay = axes.at(1);
+        bb.x0 = ax.lowest();
+        bb.x1 = ax.highest();
+        bb.y0 = ay.lowest();
+        bb.y1 = ay.highest();
+        bb.nx0 = ax.count.at(bb.x0);
+        bb.nx1 = ax.count.at(bb.x1);
+        bb.ny0 = ay.count.at(bb.y0);
+        bb.ny1 = ay.count.at(bb.y1);
+    }
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif
@@ -41,7 +41,9 @@
 #include <vector>
 #include "fast_bels.h"
 #include "log.h"
+#include "pin_histogram.h"
 #include "place_common.h"
+#include "profiler.h"
 #include "scope_lock.h"
 #include "timing.h"
 #include "util.h"
@@ -63,6 +65,15 @@ class SAPlacer
         }
     };
 
+    // Cached timing data for an arc. The weight is criticality^crit_exp (or zero for arcs that are ignored for
+    // timing), and the delays are memoised for the committed placement and the last trial placement of the arc
+    struct ArcTimingData
+    {
+        float weight = 0;
+        BelId curr_src, curr_dst, trial_src, trial_dst;
+        delay_t curr_delay = 0, trial_delay = 0;
+    };
+
   public:
     SAPlacer(Context *ctx, Placer1Cfg cfg)
             : ctx(ctx), fast_bels(ctx, /*check_bel_available=*/false, cfg.minBelsForGridPick), cfg(cfg), tmg(ctx)
@@ -88,12 +99,15 @@ class SAPlacer
 
         net_bounds.resize(ctx->nets.size());
         net_arc_tcost.resize(ctx->nets.size());
+        net_arc_tdata.resize(ctx->nets.size());
+        net_hist.resize(ctx->nets.size());
         old_udata.reserve(ctx->nets.size());
         net_by_udata.reserve(ctx->nets.size());
         decltype(NetInfo::udata) n = 0;
         for (auto &net : ctx->nets) {
             old_udata.emplace_back(net.second->udata);
             net_arc_tcost.at(n).resize(net.second->users.capacity());
+            net_arc_tdata.at(n).resize(net.second->users.capacity());
             net.second->udata = n++;
             net_by_udata.push_back(net.second.get());
         }
@@ -259,6 +273,7 @@ class SAPlacer
 
         // Main simulated annealing loop
         for (int iter = 1;; iter++) {
+            NPNR_PROFILE_ZONE("sa_iteration");
             n_move = n_accept = 0;
             improved = false;
 
@@ -770,20 +785,21 @@ class SAPlacer
         }
 
         FastBels::FastBelsData *bel_data;
-        auto type_cnt = fast_bels.getBelsForCellType(targetType, &bel_data);
+        const FastBels::FastBelsIndex *bel_index;
+        auto type_cnt = fast_bels.getBelsForCellType(targetType, &bel_data, &bel_index);
+
+        int x0 = std::max(curr_loc.x - dx, 0), y0 = std::max(curr_loc.y - dy, 0);
+        int x1 = x0 + 2 * dx, y1 = y0 + 2 * dy;
+        if (cfg.minBelsForGridPick >= 0 && type_cnt < cfg.minBelsForGridPick)
+            x0 = y0 = x1 = y1 = 0;
+        // Pick uniformly among the non-empty locations in range, rather than rejecting empty ones
+        int loc_count = bel_index->count(x0, y0, x1, y1);
+        if (loc_count == 0)
+            return BelId();
 
         while (true) {
-            int nx = ctx->rng(2 * dx + 1) + std::max(curr_loc.x - dx, 0);
-            int ny = ctx->rng(2 * dy + 1) + std::max(curr_loc.y - dy, 0);
-            if (cfg.minBelsForGridPick >= 0 && type_cnt < cfg.minBelsForGridPick)
-                nx = ny = 0;
-            if (nx >= int(bel_data->size()))
-                continue;
-            if (ny >= int(bel_data->at(nx).size()))
-                continue;
-            const auto &fb = bel_data->at(nx).at(ny);
-            if (fb.size() == 0)
-                continue;
+            Loc nl = bel_index->get(x0, y0, x1, y1, ctx->rng(loc_count));
+            const auto &fb = bel_data->at(nl.x).at(nl.y);
             BelId bel = fb.at(ctx->rng(int(fb.size())));
             if (force_z != -1) {
                 Loc loc = ctx->getBelLocation(bel);
@@ -853,31 +869,83 @@ class SAPlacer
         return bb;
     }
 
+    // Get the predicted delay for an arc of a net, only calling into the arch if the driver/sink bel pair
+    // doesn't match either the committed or the most recently evaluated placement of the arc
+    inline delay_t get_arc_delay(NetInfo *net, store_index<PortRef> user, ArcTimingData &td)
+    {
+        BelId src_bel = net->driver.cell->bel, dst_bel = net->users.at(user).cell->bel;
+        if (src_bel == td.curr_src && dst_bel == td.curr_dst)
+            return td.curr_delay;
+        if (src_bel != td.trial_src || dst_bel != td.trial_dst) {
+            td.trial_src = src_bel;
+            td.trial_dst = dst_bel;
+            td.trial_delay = ctx->predictArcDelay(net, net->users.at(user));
+        }
+        return td.trial_delay;
+    }
+
+    // Mark the most recently evaluated delay of an arc as belonging to the committed placement
+    inline void commit_arc_delay(ArcTimingData &td)
+    {
+        td.curr_src = td.trial_src;
+        td.curr_dst = td.trial_dst;
+        td.curr_delay = td.trial_delay;
+    }
+
     // Get the timing cost for an arc of a net
-    inline double get_timing_cost(NetInfo *net, const PortRef &user)
+    inline double get_timing_cost(NetInfo *net, store_index<PortRef> user)
     {
-        int cc;
-        if (net->driver.cell == nullptr)
-            return 0;
-        if (ctx->getPortTimingClass(net->driver.cell, net->driver.port, cc) == TMG_IGNORE)
+        auto &td = net_arc_tdata[net->udata][user.idx()];
+        if (td.weight == 0)
             return 0;
+        double delay = ctx->getDelayNS(get_arc_delay(net, user, td));
+        return delay * td.weight;
+    }
 
-        float crit = tmg.get_criticality(CellPortKey(user));
-        double delay = ctx->getDelayNS(ctx->predictArcDelay(net, user));
-        return delay * std::pow(crit, crit_exp);
+    // Set up the pin histogram of a high-fanout net from the current placement
+    void setup_net_hist(NetInfo *net)
+    {
+        auto &hist = net_hist[net->udata];
+        if (!hist)
+            hist = std::make_unique<PinHistogram>();
+        hist->init(std::max(ctx->getGridDimX(), max_x + 1), std::max(ctx->getGridDimY(), max_y + 1));
+        hist->add(net->driver.cell->getLocation());
+        for (auto user : net->users) {
+            if (!user.cell->isPseudo() && user.cell->bel == BelId())
+                continue;
+            hist->add(user.cell->getLocation());
+        }
     }
 
     // Set up the cost maps
     void setup_costs()
     {
+        // Histograms are rebuilt from scratch, so any uncommitted changes to them are no longer relevant
+        moveChange.hist_changes.clear();
         for (auto &net : ctx->nets) {
             NetInfo *ni = net.second.get();
             if (ignore_net(ni))
                 continue;
             net_bounds[ni->udata] = get_net_bounds(ni);
-            if (cfg.timing_driven && int(ni->users.entries()) < cfg.timingFanoutThresh)
-                for (auto usr : ni->users.enumerate())
-                    net_arc_tcost[ni->udata][usr.index.idx()] = get_timing_cost(ni, usr.value);
+            if (int(ni->users.entries()) >= PinHistogram::min_fanout)
+                setup_net_hist(ni);
+            if (cfg.timing_driven && int(ni->users.entries()) < cfg.timingFanoutThresh) {
+                // Criticality-derived weights only change here, so they are cached for the whole temperature step
+                int cc;
+                bool ignored = (ctx->getPortTimingClass(ni->driver.cell, ni->driver.port, cc) == TMG_IGNORE);
+                for (auto usr : ni->users.enumerate()) {
+                    auto &td = net_arc_tdata[ni->udata][usr.index.idx()];
+                    if (ignored) {
+                        td.weight = 0;
+                    } else {
+                        float crit = tmg.get_criticality(CellPortKey(usr.value));
+                        td.weight = std::pow(crit, crit_exp);
+                    }
+                    net_arc_tcost[ni->udata][usr.index.idx()] = get_timing_cost(ni, usr.index);
+                    if (td.weight != 0)
+                        commit_arc_delay(td);
+                }
+            }
         }
     }
 
@@ -923,6 +991,9 @@ class SAPlacer
         std::vector<BoundingBox> new_net_bounds;
         std::vector<std::pair<std::pair<decltype(NetInfo::udata), store_index<PortRef>>, double>> new_arc_costs;
 
+        // Pin moves applied to the histograms of high-fanout nets; undone on reset unless the move was committed
+        std::vector<std::tuple<decltype(NetInfo::udata), Loc, Loc>> hist_changes;
+
         wirelen_t wirelen_delta = 0;
         double timing_delta = 0;
 
@@ -949,6 +1020,9 @@ class SAPlacer
             }
             for (const auto &tc : changed_arcs)
                 already_changed_arcs[tc.first][tc.second.idx()] = false;
+            for (auto hc = hist_changes.rbegin(); hc != hist_changes.rend(); ++hc)
+                p->net_hist[std::get<0>(*hc)]->move(std::get<2>(*hc), std::get<1>(*hc));
+            hist_changes.clear();
             bounds_changed_nets_x.clear();
             bounds_changed_nets_y.clear();
             changed_arcs.clear();
@@ -970,6 +1044,10 @@ class SAPlacer
                 continue;
             if (ignore_net(pn))
                 continue;
+            if (net_hist[pn->udata]) {
+                net_hist[pn->udata]->move(old_loc, curr_loc);
+                mc.hist_changes.emplace_back(pn->udata, old_loc, curr_loc);
+            }
             BoundingBox &curr_bounds = mc.new_net_bounds[pn->udata];
             // Incremental bounding box updates
             // Note that everything other than full updates are applied immediately rather than being queued,
@@ -1114,16 +1192,25 @@ class SAPlacer
         }
     }
 
+    // Recompute the bounds of a net from scratch, using its pin histogram if it has one
+    inline void recompute_net_bounds(MoveChangeData &md, decltype(NetInfo::udata) net)
+    {
+        if (net_hist[net])
+            net_hist[net]->get_bounds(md.new_net_bounds[net]);
+        else
+            md.new_net_bounds[net] = get_net_bounds(net_by_udata[net]);
+    }
+
     void compute_cost_changes(MoveChangeData &md)
     {
         for (const auto &bc : md.bounds_changed_nets_x) {
             if (md.already_bounds_changed_x[bc] == MoveChangeData::FULL_RECOMPUTE)
-                md.new_net_bounds[bc] = get_net_bounds(net_by_udata[bc]);
+                recompute_net_bounds(md, bc);
         }
         for (const auto &bc : md.bounds_changed_nets_y) {
             if (md.already_bounds_changed_x[bc] != MoveChangeData::FULL_RECOMPUTE &&
                 md.already_bounds_changed_y[bc] == MoveChangeData::FULL_RECOMPUTE)
-                md.new_net_bounds[bc] = get_net_bounds(net_by_udata[bc]);
+                recompute_net_bounds(md, bc);
         }
 
         for (const auto &bc : md.bounds_changed_nets_x)
@@ -1135,8 +1222,7 @@ class SAPlacer
         if (cfg.timing_driven) {
             for (const auto &tc : md.changed_arcs) {
                 double old_cost = net_arc_tcost.at(tc.first).at(tc.second.idx());
-                double new_cost =
-                        get_timing_cost(net_by_udata.at(tc.first), net_by_udata.at(tc.first)->users.at(tc.second));
+                double new_cost = get_timing_cost(net_by_udata.at(tc.first), tc.second);
                 md.new_arc_costs.emplace_back(std::make_pair(tc, new_cost));
                 md.timing_delta += (new_cost - old_cost);
                 md.already_changed_arcs[tc.first][tc.second.idx()] = false;
@@ -1150,8 +1236,13 @@ class SAPlacer
             net_bounds[bc] = md.new_net_bounds[bc];
         for (const auto &bc : md.bounds_changed_nets_y)
             net_bounds[bc] = md.new_net_bounds[bc];
-        for (const auto &tc : md.new_arc_costs)
+        for (const auto &tc : md.new_arc_costs) {
             net_arc_tcost[tc.first.first].at(tc.first.second.idx()) = tc.second;
+            auto &td = net_arc_tdata[tc.first.first].at(tc.first.second.idx());
+            if (td.weight != 0)
+                commit_arc_delay(td);
+        }
+        md.hist_changes.clear();
         curr_wirelen_cost += md.wirelen_delta;
         curr_timing_cost += md.timing_delta;
     }
@@ -1219,8 +1310,13 @@ class SAPlacer
 
     // Map nets to their bounding box (so we can skip recompute for moves that do not exceed the bounds
     std::vector<BoundingBox> net_bounds;
+    // Map high-fanout nets to histograms of their pin locations, so that moving the last pin off an edge of the
+    // bounding box doesn't require a rescan of every pin
+    std::vector<std::unique_ptr<PinHistogram>> net_hist;
     // Map net arcs to their timing cost (criticality * delay ns)
     std::vector<std::vector<double>> net_arc_tcost;
+    // Map net arcs to their cached criticality weight and memoised predicted delays
+    std::vector<std::vector<ArcTimingData>> net_arc_tdata;
 
     // Fast lookup for cell to clusters
     dict<ClusterId, std::vector<CellInfo *>> cluster2cell;
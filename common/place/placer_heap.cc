@@ -47,6 +47,7 @@
 #include "parallel_refine.h"
 #include "place_common.h"
 #include "placer1.h"
+#include "profiler.h"
 #include "scope_lock.h"
 #include "timing.h"
 #include "util.h"
@@ -267,6 +268,7 @@ class HeAPPlacer
                 update_all_chains();
 
                 legal_hpwl = total_hpwl();
+                profile_counter("heap_legal_hpwl", legal_hpwl);
                 auto run_stopt = std::chrono::high_resolution_clock::now();
 
                 IdString bucket_name = ctx->getBelBucketName(*run.begin());
@@ -510,6 +512,7 @@ class HeAPPlacer
     // Build and solve in one direction
     void build_solve_direction(bool yaxis, int iter)
     {
+        NPNR_PROFILE_ZONE("heap_solve");
         for (int i = 0; i < 5; i++) {
             EquationSystem<double> esx(solve_cells.size(), solve_cells.size());
             build_equations(esx, yaxis, iter);
@@ -834,6 +837,7 @@ class HeAPPlacer
     // Strict placement legalisation, performed after the initial HeAP spreading
     void legalise_placement_strict(bool require_validity = false)
     {
+        NPNR_PROFILE_ZONE("heap_legalise");
         auto startt = std::chrono::high_resolution_clock::now();
 
         // Unbind all cells placed in this solution
@@ -1153,6 +1157,7 @@ class HeAPPlacer
         static int seq;
         void run()
         {
+            NPNR_PROFILE_ZONE("heap_spread");
             auto startt = std::chrono::high_resolution_clock::now();
             init();
             find_overused_regions();
@@ -30,8 +30,10 @@
 
 #include "timing_opt.h"
 #include <boost/range/adaptor/reversed.hpp>
+#include <memory>
 #include <queue>
 #include "nextpnr.h"
+#include "thread_pool.h"
 #include "timing.h"
 #include "util.h"
 
@@ -45,16 +47,17 @@ class TimingOptimiser
     {
         log_info("Running timing-driven placement optimisation...\n");
         ctx->lock();
+        workers = ctx->getThreadPool();
         if (ctx->verbose)
             timing_analysis(ctx, false, true, false, false);
         tmg.setup();
         for (int i = 0; i < 30; i++) {
             log_info("   Iteration %d...\n", i);
-            tmg.run();
+            update_moved_delays();
+            tmg.run_incremental();
             setup_delay_limits();
             auto crit_paths = find_crit_paths(0.98, 50000);
-            for (auto &path : crit_paths)
-                optimise_path(path);
+            optimise_paths(crit_paths);
             if (ctx->verbose)
                 timing_analysis(ctx, false, true, false, false);
         }
@@ -63,6 +66,85 @@ class TimingOptimiser
     }
 
   private:
+    // FIXME: how to best determine d
+    static const int neighbour_dist = 2;
+
+    // The bels at one location that a cell could be moved to
+    struct TileBels
+    {
+        std::vector<BelId> free_bels, bound_bels;
+    };
+
+    // State of the search for a better placement of the cells on one critical path
+    struct PathSearch
+    {
+        std::vector<PortRef *> *path = nullptr;
+        // Current candidate Bels for cells (linked in both direction>
+        std::vector<IdString> path_cells;
+        dict<IdString, pool<BelId>> cell_neighbour_bels;
+        dict<BelId, pool<IdString>> bel_candidate_cells;
+        // When searching several paths in a batch, trial moves aren't made in the Context but only recorded here, on
+        // top of the current placement. Legality is then only checked once the solution is committed.
+        bool virtual_moves = false;
+        dict<IdString, BelId> cell_bels;
+        dict<BelId, CellInfo *> bel_cells;
+        // Seeded from the index of the path, so a search makes the same choices whichever thread runs it
+        DeterministicRNG rng;
+        uint64_t seed = 0;
+        // Lowest delay placement found, as a sequence of moves
+        std::vector<std::pair<IdString, BelId>> solution;
+        delay_t solution_delay = 0, original_delay = 0;
+        // For virtual moves, the Arch state that the search needs, gathered beforehand on the calling thread by
+        // gather_arch_state(), as Arch queries may fill caches that aren't thread safe. bel_cells then also holds the
+        // current binding of every bel the search can touch, and port_pins the bel pin used to predict the delay of
+        // every arc that it can evaluate.
+        dict<IdString, std::vector<TileBels>> cell_tile_bels;
+        dict<IdString, pool<IdString>> ignored_ports;
+        dict<CellPortKey, IdString> port_pins;
+    };
+
+    BelId cell_bel(const PathSearch &s, const CellInfo *cell) const
+    {
+        if (s.virtual_moves) {
+            auto found = s.cell_bels.find(cell->name);
+            if (found != s.cell_bels.end())
+                return found->second;
+        }
+        return cell->bel;
+    }
+
+    CellInfo *bound_cell(const PathSearch &s, BelId bel) const
+    {
+        if (s.virtual_moves)
+            return s.bel_cells.at(bel);
+        return ctx->getBoundBelCell(bel);
+    }
+
+    delay_t predict_delay(const PathSearch &s, const NetInfo *net, const PortRef &sink) const
+    {
+        if (!s.virtual_moves)
+            return ctx->predictArcDelay(net, sink);
+        if (net->driver.cell == nullptr)
+            return 0;
+        BelId driver_bel = cell_bel(s, net->driver.cell), sink_bel = cell_bel(s, sink.cell);
+        if (driver_bel == BelId() || sink_bel == BelId())
+            return 0;
+        // As Context::predictArcDelay, but with the pins looked up beforehand. predictDelay itself only depends on the
+        // bels and pins, so can be called from any thread (as the parallel detail placer also does)
+        IdString driver_pin = s.port_pins.at(CellPortKey(net->driver)), sink_pin = s.port_pins.at(CellPortKey(sink));
+        if (driver_pin == IdString() || sink_pin == IdString())
+            return 0;
+        return ctx->predictDelay(driver_bel, driver_pin, sink_bel, sink_pin);
+    }
+
+    bool port_ignored(const PathSearch &s, const CellInfo *cell, IdString port) const
+    {
+        if (s.virtual_moves)
+            return s.ignored_ports.at(cell->name).count(port);
+        int nc;
+        return ctx->getPortTimingClass(cell, port, nc) == TMG_IGNORE;
+    }
+
     void setup_delay_limits()
     {
         max_net_delay.clear();
@@ -84,21 +166,20 @@ class TimingOptimiser
         }
     }
 
-    bool check_cell_delay_limits(CellInfo *cell)
+    bool check_cell_delay_limits(const PathSearch &s, CellInfo *cell)
     {
         for (const auto &port : cell->ports) {
-            int nc;
-            if (ctx->getPortTimingClass(cell, port.first, nc) == TMG_IGNORE)
+            if (port_ignored(s, cell, port.first))
                 continue;
             NetInfo *net = port.second.net;
             if (net == nullptr)
                 continue;
             if (port.second.type == PORT_IN) {
-                if (net->driver.cell == nullptr || net->driver.cell->bel == BelId())
+                if (net->driver.cell == nullptr || cell_bel(s, net->driver.cell) == BelId())
                     continue;
                 for (auto user : net->users) {
                     if (user.cell == cell && user.port == port.first) {
-                        if (ctx->predictArcDelay(net, user) >
+                        if (predict_delay(s, net, user) >
                             1.1 * max_net_delay.at(std::make_pair(cell->name, port.first)))
                             return false;
                     }
@@ -107,10 +188,10 @@ class TimingOptimiser
             } else if (port.second.type == PORT_OUT) {
                 for (auto user : net->users) {
                     // This could get expensive for high-fanout nets??
-                    BelId dstBel = user.cell->bel;
+                    BelId dstBel = cell_bel(s, user.cell);
                     if (dstBel == BelId())
                         continue;
-                    if (ctx->predictArcDelay(net, user) >
+                    if (predict_delay(s, net, user) >
                         1.1 * max_net_delay.at(std::make_pair(user.cell->name, user.port))) {
 
                         return false;
@@ -134,96 +215,209 @@ class TimingOptimiser
             ctx->bindBel(oldBel, other_cell, STRENGTH_WEAK);
         }
         ctx->bindBel(newBel, cell, STRENGTH_WEAK);
+        moved_cells.insert(cell->name);
+        if (other_cell != nullptr)
+            moved_cells.insert(other_cell->name);
         return oldBel;
     }
 
+    BelId cell_swap_bel(PathSearch &s, CellInfo *cell, BelId newBel)
+    {
+        if (!s.virtual_moves)
+            return cell_swap_bel(cell, newBel);
+        BelId oldBel = cell_bel(s, cell);
+        if (oldBel == newBel)
+            return oldBel;
+        CellInfo *other_cell = bound_cell(s, newBel);
+        NPNR_ASSERT(other_cell == nullptr || other_cell->belStrength <= STRENGTH_WEAK);
+        s.bel_cells[oldBel] = other_cell;
+        if (other_cell != nullptr)
+            s.cell_bels[other_cell->name] = oldBel;
+        s.bel_cells[newBel] = cell;
+        s.cell_bels[cell->name] = newBel;
+        return oldBel;
+    }
+
+    // Update the analyser with the route delays of nets connected to cells that have moved since the last call
+    void update_moved_delays()
+    {
+        pool<IdString> moved_nets;
+        for (auto cell_name : moved_cells) {
+            for (auto &port : ctx->cells.at(cell_name)->ports) {
+                NetInfo *ni = port.second.net;
+                if (ni != nullptr && moved_nets.insert(ni->name).second)
+                    tmg.update_net_delays(ni);
+            }
+        }
+        moved_cells.clear();
+    }
+
     // Check that a series of moves are both legal and remain within maximum delay bounds
     // Moves are specified as a vector of pairs <cell, oldBel>
-    bool acceptable_move(std::vector<std::pair<CellInfo *, BelId>> &move, bool check_delays = true)
+    bool acceptable_move(const PathSearch &s, std::vector<std::pair<CellInfo *, BelId>> &move,
+                         bool check_delays = true)
     {
         for (auto &entry : move) {
-            if (!ctx->isBelLocationValid(entry.first->bel))
-                return false;
-            if (!ctx->isBelLocationValid(entry.second))
-                return false;
+            if (!s.virtual_moves) {
+                if (!ctx->isBelLocationValid(entry.first->bel))
+                    return false;
+                if (!ctx->isBelLocationValid(entry.second))
+                    return false;
+            }
             if (!check_delays)
                 continue;
-            if (!check_cell_delay_limits(entry.first))
+            if (!check_cell_delay_limits(s, entry.first))
                 return false;
             // We might have swapped another cell onto the original bel. Check this for max delay violations
             // too
-            CellInfo *swapped = ctx->getBoundBelCell(entry.second);
-            if (swapped != nullptr && !check_cell_delay_limits(swapped))
+            CellInfo *swapped = bound_cell(s, entry.second);
+            if (swapped != nullptr && !check_cell_delay_limits(s, swapped))
                 return false;
         }
         return true;
     }
 
-    int find_neighbours(CellInfo *cell, IdString prev_cell, int d, bool allow_swap)
+    // Go through all the Bels at each location within d of a cell
+    // First, find all bels of the correct type that are either unbound or bound normally
+    // Strongly bound bels are ignored
+    // FIXME: This means that we cannot touch carry chains or similar relatively constrained macros
+    std::vector<TileBels> find_tile_bels(CellInfo *cell, int d)
     {
-        BelId curr = cell->bel;
-        Loc curr_loc = ctx->getBelLocation(curr);
-        int found_count = 0;
-        cell_neighbour_bels[cell->name] = pool<BelId>{};
+        std::vector<TileBels> tiles;
+        Loc curr_loc = ctx->getBelLocation(cell->bel);
         for (int dy = -d; dy <= d; dy++) {
             for (int dx = -d; dx <= d; dx++) {
-                // Go through all the Bels at this location
-                // First, find all bels of the correct type that are either unbound or bound normally
-                // Strongly bound bels are ignored
-                // FIXME: This means that we cannot touch carry chains or similar relatively constrained macros
-                std::vector<BelId> free_bels_at_loc;
-                std::vector<BelId> bound_bels_at_loc;
+                tiles.emplace_back();
                 for (auto bel : ctx->getBelsByTile(curr_loc.x + dx, curr_loc.y + dy)) {
                     if (!ctx->isValidBelForCellType(cell->type, bel))
                         continue;
                     CellInfo *bound = ctx->getBoundBelCell(bel);
                     if (bound == nullptr) {
-                        free_bels_at_loc.push_back(bel);
+                        tiles.back().free_bels.push_back(bel);
                     } else if (bound->belStrength <= STRENGTH_WEAK && bound->cluster == ClusterId()) {
-                        bound_bels_at_loc.push_back(bel);
+                        tiles.back().bound_bels.push_back(bel);
                     }
                 }
-                BelId candidate;
-
-                while (!free_bels_at_loc.empty() || !bound_bels_at_loc.empty()) {
-                    BelId try_bel;
-                    if (!free_bels_at_loc.empty()) {
-                        int try_idx = ctx->rng(int(free_bels_at_loc.size()));
-                        try_bel = free_bels_at_loc.at(try_idx);
-                        free_bels_at_loc.erase(free_bels_at_loc.begin() + try_idx);
-                    } else {
-                        int try_idx = ctx->rng(int(bound_bels_at_loc.size()));
-                        try_bel = bound_bels_at_loc.at(try_idx);
-                        bound_bels_at_loc.erase(bound_bels_at_loc.begin() + try_idx);
-                    }
-                    if (bel_candidate_cells.count(try_bel) && !allow_swap) {
-                        // Overlap is only allowed if it is with the previous cell (this is handled by removing those
-                        // edges in the graph), or if allow_swap is true to deal with cases where overlap means few
-                        // neighbours are identified
-                        if (bel_candidate_cells.at(try_bel).size() > 1 ||
-                            (bel_candidate_cells.at(try_bel).size() == 1 &&
-                             *(bel_candidate_cells.at(try_bel).begin()) != prev_cell))
-                            continue;
-                    }
-                    // TODO: what else to check here?
-                    candidate = try_bel;
-                    break;
+            }
+        }
+        return tiles;
+    }
+
+    void gather_port_pin(PathSearch &s, const PortRef &port)
+    {
+        CellPortKey key(port);
+        if (s.port_pins.count(key))
+            return;
+        IdString &pin = s.port_pins[key];
+        // Pick the first pin for a prediction, as Context::predictArcDelay does
+        for (auto bel_pin : ctx->getBelPinsForCellPin(port.cell, port.port)) {
+            pin = bel_pin;
+            break;
+        }
+    }
+
+    // Gather the Arch state a search with virtual moves needs, so that it can then run on a worker thread
+    void gather_arch_state(PathSearch &s)
+    {
+        std::vector<CellInfo *> checked_cells;
+        for (auto cell_name : s.path_cells) {
+            CellInfo *cell = ctx->cells.at(cell_name).get();
+            auto &tiles = s.cell_tile_bels[cell_name];
+            tiles = find_tile_bels(cell, neighbour_dist);
+            s.bel_cells[cell->bel] = cell;
+            checked_cells.push_back(cell);
+            for (auto &tile : tiles) {
+                for (auto bel : tile.free_bels)
+                    s.bel_cells[bel] = nullptr;
+                for (auto bel : tile.bound_bels) {
+                    CellInfo *bound = ctx->getBoundBelCell(bel);
+                    s.bel_cells[bel] = bound;
+                    checked_cells.push_back(bound);
+                }
+            }
+        }
+        for (auto cell : checked_cells) {
+            if (s.ignored_ports.count(cell->name))
+                continue;
+            auto &ignored = s.ignored_ports[cell->name];
+            for (const auto &port : cell->ports) {
+                int nc;
+                if (ctx->getPortTimingClass(cell, port.first, nc) == TMG_IGNORE)
+                    ignored.insert(port.first);
+                // The arcs check_cell_delay_limits may predict the delay of
+                NetInfo *net = port.second.net;
+                if (net == nullptr || net->driver.cell == nullptr)
+                    continue;
+                gather_port_pin(s, net->driver);
+                if (port.second.type == PORT_IN) {
+                    gather_port_pin(s, net->users.at(port.second.user_idx));
+                } else if (port.second.type == PORT_OUT) {
+                    for (auto &user : net->users)
+                        gather_port_pin(s, user);
                 }
+            }
+        }
+        // The arcs along the path itself
+        for (auto port : *s.path) {
+            NetInfo *net = port->cell->ports.at(port->port).net;
+            if (net == nullptr || net->driver.cell == nullptr)
+                continue;
+            gather_port_pin(s, net->driver);
+            gather_port_pin(s, *port);
+        }
+    }
 
-                if (candidate != BelId()) {
-                    cell_neighbour_bels[cell->name].insert(candidate);
-                    bel_candidate_cells[candidate].insert(cell->name);
-                    // Work out if we need to delete any overlap
-                    std::vector<IdString> overlap;
-                    for (auto other : bel_candidate_cells[candidate])
-                        if (other != cell->name && other != prev_cell)
-                            overlap.push_back(other);
-                    if (overlap.size() > 0)
-                        NPNR_ASSERT(allow_swap);
-                    for (auto ov : overlap) {
-                        bel_candidate_cells[candidate].erase(ov);
-                        cell_neighbour_bels[ov].erase(candidate);
-                    }
+    int find_neighbours(PathSearch &s, CellInfo *cell, IdString prev_cell, int d, bool allow_swap)
+    {
+        auto &cell_neighbour_bels = s.cell_neighbour_bels;
+        auto &bel_candidate_cells = s.bel_candidate_cells;
+        auto &rng = s.rng;
+        int found_count = 0;
+        cell_neighbour_bels[cell->name] = pool<BelId>{};
+        std::vector<TileBels> tiles = s.virtual_moves ? s.cell_tile_bels.at(cell->name) : find_tile_bels(cell, d);
+        for (auto &tile : tiles) {
+            auto &free_bels_at_loc = tile.free_bels;
+            auto &bound_bels_at_loc = tile.bound_bels;
+            BelId candidate;
+
+            while (!free_bels_at_loc.empty() || !bound_bels_at_loc.empty()) {
+                BelId try_bel;
+                if (!free_bels_at_loc.empty()) {
+                    int try_idx = rng.rng(int(free_bels_at_loc.size()));
+                    try_bel = free_bels_at_loc.at(try_idx);
+                    free_bels_at_loc.erase(free_bels_at_loc.begin() + try_idx);
+                } else {
+                    int try_idx = rng.rng(int(bound_bels_at_loc.size()));
+                    try_bel = bound_bels_at_loc.at(try_idx);
+                    bound_bels_at_loc.erase(bound_bels_at_loc.begin() + try_idx);
+                }
+                if (bel_candidate_cells.count(try_bel) && !allow_swap) {
+                    // Overlap is only allowed if it is with the previous cell (this is handled by removing those
+                    // edges in the graph), or if allow_swap is true to deal with cases where overlap means few
+                    // neighbours are identified
+                    if (bel_candidate_cells.at(try_bel).size() > 1 ||
+                        (bel_candidate_cells.at(try_bel).size() == 1 &&
+                         *(bel_candidate_cells.at(try_bel).begin()) != prev_cell))
+                        continue;
+                }
+                // TODO: what else to check here?
+                candidate = try_bel;
+                break;
+            }
+
+            if (candidate != BelId()) {
+                cell_neighbour_bels[cell->name].insert(candidate);
+                bel_candidate_cells[candidate].insert(cell->name);
+                // Work out if we need to delete any overlap
+                std::vector<IdString> overlap;
+                for (auto other : bel_candidate_cells[candidate])
+                    if (other != cell->name && other != prev_cell)
+                        overlap.push_back(other);
+                if (overlap.size() > 0)
+                    NPNR_ASSERT(allow_swap);
+                for (auto ov : overlap) {
+                    bel_candidate_cells[candidate].erase(ov);
+                    cell_neighbour_bels[ov].erase(candidate);
                 }
             }
         }
@@ -351,12 +545,14 @@ class TimingOptimiser
         return crit_paths;
     }
 
-    void optimise_path(std::vector<PortRef *> &path)
+    // Find the cells on a path that can be moved; returns false if there are too few to be worth searching
+    bool find_path_cells(PathSearch &s)
     {
+        auto &path = *s.path;
+        auto &path_cells = s.path_cells;
+        bool debug = ctx->debug && (!s.virtual_moves || !workers);
         path_cells.clear();
-        cell_neighbour_bels.clear();
-        bel_candidate_cells.clear();
-        if (ctx->debug)
+        if (debug)
             log_info("Optimising the following path: \n");
 
         auto front_port = path.front();
@@ -370,7 +566,7 @@ class TimingOptimiser
         }
 
         for (auto port : path) {
-            if (ctx->debug) {
+            if (debug) {
                 float crit = tmg.get_criticality(CellPortKey(*port));
                 log_info("    %s.%s at %s crit %0.02f\n", port->cell->name.c_str(ctx), port->port.c_str(ctx),
                          ctx->nameOfBel(port->cell->bel), crit);
@@ -380,19 +576,33 @@ class TimingOptimiser
             if (port->cell->belStrength > STRENGTH_WEAK || !cfg.cellTypes.count(port->cell->type) ||
                 port->cell->cluster != ClusterId())
                 continue;
-            if (ctx->debug)
+            if (debug)
                 log_info("        can move\n");
             path_cells.push_back(port->cell->name);
         }
 
         if (path_cells.size() < 2) {
-            if (ctx->debug) {
+            if (debug) {
                 log_info("Too few moveable cells; skipping path\n");
                 log_break();
             }
 
-            return;
+            return false;
         }
+        return true;
+    }
+
+    // Search for the lowest delay placement of the movable cells of a path, setting s.solution if one is found. The
+    // placement is unchanged afterwards.
+    void search_path(PathSearch &s)
+    {
+        auto &path = *s.path;
+        auto &path_cells = s.path_cells;
+        auto &cell_neighbour_bels = s.cell_neighbour_bels;
+        bool debug = ctx->debug && (!s.virtual_moves || !workers);
+        cell_neighbour_bels.clear();
+        s.bel_candidate_cells.clear();
+        s.solution.clear();
 
         // Calculate original delay before touching anything
         delay_t original_delay = 0;
@@ -401,18 +611,18 @@ class TimingOptimiser
             auto &port = path.at(i)->cell->ports.at(path.at(i)->port);
             NetInfo *pn = port.net;
             if (port.user_idx)
-                original_delay += ctx->predictArcDelay(pn, pn->users.at(port.user_idx));
+                original_delay += predict_delay(s, pn, pn->users.at(port.user_idx));
         }
+        s.original_delay = original_delay;
 
         IdString last_cell;
-        const int d = 2; // FIXME: how to best determine d
         for (auto cell : path_cells) {
             // FIXME: when should we allow swapping due to a lack of candidates
-            find_neighbours(ctx->cells[cell].get(), last_cell, d, false);
+            find_neighbours(s, ctx->cells.at(cell).get(), last_cell, neighbour_dist, false);
             last_cell = cell;
         }
 
-        if (ctx->debug) {
+        if (debug) {
             for (auto cell : path_cells) {
                 log_info("Candidate neighbours for %s (%s):\n", cell.c_str(ctx), ctx->nameOfBel(ctx->cells[cell]->bel));
                 for (auto neigh : cell_neighbour_bels.at(cell)) {
@@ -430,15 +640,15 @@ class TimingOptimiser
         for (auto startbel : cell_neighbour_bels[path_cells.front()]) {
             // Swap for legality check
             CellInfo *cell = ctx->cells.at(path_cells.front()).get();
-            BelId origBel = cell_swap_bel(cell, startbel);
+            BelId origBel = cell_swap_bel(s, cell, startbel);
             std::vector<std::pair<CellInfo *, BelId>> move{std::make_pair(cell, origBel)};
-            if (acceptable_move(move)) {
+            if (acceptable_move(s, move)) {
                 auto entry = std::make_pair(0, startbel);
                 visit.push(entry);
                 cumul_costs[path_cells.front()][startbel] = 0;
             }
             // Swap back
-            cell_swap_bel(cell, origBel);
+            cell_swap_bel(s, cell, origBel);
         }
 
         while (!visit.empty()) {
@@ -460,7 +670,7 @@ class TimingOptimiser
             }
             for (auto rt_entry : boost::adaptors::reverse(route_to_entry)) {
                 CellInfo *cell = ctx->cells.at(rt_entry.first).get();
-                BelId origBel = cell_swap_bel(cell, rt_entry.second);
+                BelId origBel = cell_swap_bel(s, cell, rt_entry.second);
                 move.push_back(std::make_pair(cell, origBel));
             }
 
@@ -472,7 +682,7 @@ class TimingOptimiser
                 // Experimentally swap the next path cell onto the neighbour bel we are trying
                 IdString ncname = path_cells.at(entry.first + 1);
                 CellInfo *next_cell = ctx->cells.at(ncname).get();
-                BelId origBel = cell_swap_bel(next_cell, neighbour);
+                BelId origBel = cell_swap_bel(s, next_cell, neighbour);
                 move.push_back(std::make_pair(next_cell, origBel));
 
                 delay_t total_delay = 0;
@@ -481,7 +691,7 @@ class TimingOptimiser
                     auto &port = path.at(i)->cell->ports.at(path.at(i)->port);
                     NetInfo *pn = port.net;
                     if (port.user_idx)
-                        total_delay += ctx->predictArcDelay(pn, pn->users.at(port.user_idx));
+                        total_delay += predict_delay(s, pn, pn->users.at(port.user_idx));
                     if (path.at(i)->cell == next_cell)
                         break;
                 }
@@ -491,7 +701,7 @@ class TimingOptimiser
                 if (!cumul_costs.count(ncname) || !cumul_costs.at(ncname).count(neighbour) ||
                     cumul_costs.at(ncname).at(neighbour) > total_delay) {
                     // Now check that the swaps we have made to get here are legal and meet max delay requirements
-                    if (acceptable_move(move)) {
+                    if (acceptable_move(s, move)) {
                         cumul_costs[ncname][neighbour] = total_delay;
                         backtrace[std::make_pair(ncname, neighbour)] = std::make_pair(cellname, entry.second);
                         if (!to_visit.count(std::make_pair(entry.first + 1, neighbour)))
@@ -499,14 +709,14 @@ class TimingOptimiser
                     }
                 }
                 // Revert the experimental swap
-                cell_swap_bel(move.back().first, move.back().second);
+                cell_swap_bel(s, move.back().first, move.back().second);
                 move.pop_back();
             }
 
             // Revert move by swapping cells back to their original order
             // Execute swaps in reverse order to how we made them originally
             for (auto move_entry : boost::adaptors::reverse(move)) {
-                cell_swap_bel(move_entry.first, move_entry.second);
+                cell_swap_bel(s, move_entry.first, move_entry.second);
             }
         }
 
@@ -527,10 +737,18 @@ class TimingOptimiser
                 cursor = backtrace.at(cursor);
                 route_to_solution.push_back(cursor);
             }
+            s.solution.assign(route_to_solution.rbegin(), route_to_solution.rend());
+            s.solution_delay = lowest->second;
+        }
+    }
+
+    void apply_solution(PathSearch &s)
+    {
+        if (!s.solution.empty()) {
             if (ctx->debug)
                 log_info("Found a solution with cost %.02f ns (existing path %.02f ns)\n",
-                         ctx->getDelayNS(lowest->second), ctx->getDelayNS(original_delay));
-            for (auto rt_entry : boost::adaptors::reverse(route_to_solution)) {
+                         ctx->getDelayNS(s.solution_delay), ctx->getDelayNS(s.original_delay));
+            for (auto rt_entry : s.solution) {
                 CellInfo *cell = ctx->cells.at(rt_entry.first).get();
                 cell_swap_bel(cell, rt_entry.second);
                 if (ctx->debug)
@@ -545,15 +763,108 @@ class TimingOptimiser
             log_break();
     }
 
-    // Current candidate Bels for cells (linked in both direction>
-    std::vector<IdString> path_cells;
-    dict<IdString, pool<BelId>> cell_neighbour_bels;
-    dict<BelId, pool<IdString>> bel_candidate_cells;
+    void optimise_path(std::vector<PortRef *> &path, uint64_t seed)
+    {
+        PathSearch s;
+        s.path = &path;
+        s.seed = seed;
+        s.rng.rngseed(seed);
+        if (!find_path_cells(s))
+            return;
+        search_path(s);
+        apply_solution(s);
+    }
+
+    // Commit a solution found using virtual moves. If an earlier commit in the same batch has touched any of the bels
+    // it uses, or it turns out not to be legal (the virtual search skips the bel location checks), it is undone and the
+    // path is searched again on the current placement instead.
+    void commit_solution(PathSearch &s, pool<BelId> &touched_bels)
+    {
+        if (s.solution.empty())
+            return;
+        for (auto &rt_entry : s.solution) {
+            if (touched_bels.count(rt_entry.second) || touched_bels.count(ctx->cells.at(rt_entry.first)->bel)) {
+                optimise_path(*s.path, s.seed);
+                for (auto cell : s.path_cells)
+                    touched_bels.insert(ctx->cells.at(cell)->bel);
+                return;
+            }
+        }
+        if (ctx->debug)
+            log_info("Optimising path ending at %s.%s\n", s.path->back()->cell->name.c_str(ctx),
+                     s.path->back()->port.c_str(ctx));
+        std::vector<std::pair<CellInfo *, BelId>> move;
+        for (auto &rt_entry : s.solution) {
+            CellInfo *cell = ctx->cells.at(rt_entry.first).get();
+            BelId origBel = cell_swap_bel(cell, rt_entry.second);
+            move.push_back(std::make_pair(cell, origBel));
+            touched_bels.insert(origBel);
+            touched_bels.insert(rt_entry.second);
+        }
+        // The moves are now made in the Context, so check them there
+        s.virtual_moves = false;
+        if (!acceptable_move(s, move)) {
+            for (auto move_entry : boost::adaptors::reverse(move))
+                cell_swap_bel(move_entry.first, move_entry.second);
+            if (ctx->debug)
+                log_info("Solution is not legal, searching again\n");
+            optimise_path(*s.path, s.seed);
+            for (auto cell : s.path_cells)
+                touched_bels.insert(ctx->cells.at(cell)->bel);
+        } else if (ctx->debug) {
+            log_info("Found a solution with cost %.02f ns (existing path %.02f ns)\n",
+                     ctx->getDelayNS(s.solution_delay), ctx->getDelayNS(s.original_delay));
+        }
+    }
+
+    // Optimise a set of critical paths. Consecutive paths with no movable cells in common are searched as a batch, in
+    // parallel with more than one thread, and their solutions are then committed in order. Paths are batched the same
+    // way whatever the number of threads, so the result doesn't depend on it.
+    void optimise_paths(std::vector<std::vector<PortRef *>> &paths)
+    {
+        const size_t max_batch = 64;
+        uint64_t base_seed = ctx->rng64();
+        size_t next = 0;
+        while (next < paths.size()) {
+            std::vector<PathSearch> batch;
+            pool<IdString> batch_cells;
+            for (; next < paths.size() && batch.size() < max_batch; next++) {
+                PathSearch s;
+                s.path = &paths.at(next);
+                s.virtual_moves = true;
+                if (!find_path_cells(s))
+                    continue;
+                if (std::any_of(s.path_cells.begin(), s.path_cells.end(),
+                                [&](IdString cell) { return batch_cells.count(cell); }))
+                    break;
+                batch_cells.insert(s.path_cells.begin(), s.path_cells.end());
+                s.seed = base_seed ^ ((next + 1) * 0x9E3779B97F4A7C15ULL);
+                s.rng.rngseed(s.seed);
+                gather_arch_state(s);
+                batch.push_back(std::move(s));
+            }
+            auto search = [&](int i) { search_path(batch.at(i)); };
+            if (workers) {
+                workers->run(int(batch.size()), search);
+            } else {
+                for (int i = 0; i < int(batch.size()); i++)
+                    search(i);
+            }
+            pool<BelId> touched_bels;
+            for (auto &s : batch)
+                commit_solution(s, touched_bels);
+        }
+    }
+
     // Map cell ports to net delay limit
     dict<std::pair<IdString, IdString>, delay_t> max_net_delay;
+    // Cells that have been moved since the last timing update
+    pool<IdString> moved_cells;
     Context *ctx;
     TimingOptCfg cfg;
     TimingAnalyser tmg;
+    // The Context's threads, used to search non-overlapping paths in parallel; nullptr with only one thread
+    ThreadPool *workers = nullptr;
 };
 
 bool timing_opt(Context *ctx, TimingOptCfg cfg) { return TimingOptimiser(ctx, cfg).optimise(); }
@@ -39,6 +39,7 @@
 
 #include "log.h"
 #include "nextpnr.h"
+#include "profiler.h"
 #include "router1.h"
 #include "scope_lock.h"
 #include "timing.h"
@@ -1415,6 +1416,7 @@ struct Router2
         if (timing_driven)
             tmg.run(true);
         do {
+            NPNR_PROFILE_ZONE("router2_iteration");
             ctx->sorted_shuffle(route_queue);
 
             if (timing_driven && int(route_queue.size()) >= 30) {
@@ -1435,6 +1437,7 @@ struct Router2
             update_route_delays();
             route_queue.clear();
             update_congestion();
+            profile_counter("router2_overused_wires", overused_wires);
 
             if (!cfg.heatmap.empty()) {
                 std::string filename(cfg.heatmap + "_" + std::to_string(iter) + ".csv");
@@ -1445,8 +1448,9 @@ struct Router2
                 log_info("        wrote wiretype heatmap to %s.\n", filename.c_str());
             }
             int tmgfail = 0;
+            // Only the nets routed this iteration have new delays, so an incremental update is enough
             if (timing_driven)
-                tmg.run(false);
+                tmg.run_incremental();
             if (timing_driven_ripup && iter < 1500) {
                 for (size_t i = 0; i < nets_by_udata.size(); i++) {
                     NetInfo *ni = nets_by_udata.at(i);
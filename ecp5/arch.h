@@ -21,6 +21,7 @@
 #ifndef ECP5_ARCH_H
 #define ECP5_ARCH_H
 
+#include <mutex>
 #include <set>
 #include <sstream>
 
@@ -1073,6 +1074,8 @@ struct Arch : BaseArch<ArchRanges>
     dict<WireId, std::pair<int, int>> wire_loc_overrides;
     void setup_wire_locations();
 
+    // Cell delays are also looked up from the worker threads of writeSDF
+    mutable std::mutex celldelay_mutex;
     mutable dict<DelayKey, std::pair<bool, DelayQuad>> celldelay_cache;
 
     static const std::string defaultPlacer;
@@ -138,7 +138,7 @@ void Arch::expand_macros()
                             size_t bit = param_rule.slice_bits[i];
                             if (bit >= prim_bits.size())
                                 continue;
-                            value.str.at(i) = prim_bits.get(bit) ? Property::S1 : Property::S0;
+                            value.set_bit(i, prim_bits.get(bit) ? Property::S1 : Property::S0);
                         }
                         inst_cell->params[inst_param] = value;
                     } else if (param_rule.rule_type == PARAM_MAP_TABLE) {
@@ -210,17 +210,15 @@ struct FabFasmWriter
             if (param.second.is_string) {
                 // enum type parameter
                 out << prefix << param.first.c_str(ctx) << "." << param.second.str << std::endl;
-            } else if (param.second.str.size() == 1) {
+            } else if (param.second.size() == 1) {
                 // boolean type parameter
                 if (param.second.intval != 0)
                     out << prefix << param.first.c_str(ctx) << std::endl;
             } else {
                 // vector type parameter
-                int msb = int(param.second.str.size()) - 1;
+                int msb = int(param.second.size()) - 1;
                 out << prefix << param.first.c_str(ctx) << "[" << msb << ":0] = ";
-                for (auto bit : boost::adaptors::reverse(param.second.str))
-                    out << bit;
-                out << std::endl;
+                out << param.second.to_string() << std::endl;
             }
         }
     }
@@ -75,9 +75,8 @@ struct FabulousPacker
             for (unsigned i = 0; i < prim_len; i += orig_init_len) {
                 auto chunk = inst_init.extract(0, orig_init_len);
                 for (unsigned j = 0; j < orig_init_len; j++)
-                    new_init.str.at(i + j) = chunk.str.at(j);
+                    new_init.set_bit(i + j, chunk.bit(j));
             }
-            new_init.update_intval();
             ci->params[id_INIT] = new_init;
         }
     }
@@ -288,10 +287,9 @@ struct FabulousPacker
                 // configure LUT as a thru
                 Property init(1U << cfg.clb.lut_k);
                 for (unsigned i = 0; i < (1U << cfg.clb.lut_k); i += 2) {
-                    init.str[i] = Property::S0;
-                    init.str[i + 1] = Property::S1;
+                    init.set_bit(i, Property::S0);
+                    init.set_bit(i + 1, Property::S1);
                 }
-                init.update_intval();
                 ci->params[id_INIT] = init;
                 ci->params[id_FF] = 1;
             }
@@ -423,7 +423,7 @@ struct FasmBackend
                     for (auto &p2l : phys_to_log[k])
                         log_index |= (1 << log_to_bit[p2l]);
                 }
-                bits[j] = (init.str.at(log_index) == Property::S1);
+                bits[j] = (init.bit(log_index) == Property::S1);
             }
         }
         return bits;
@@ -1316,9 +1316,9 @@ struct FasmBackend
                             auto &init0 = ci->params.at(param);
                             has_init = true;
                             for (int k = half; k < 256; k += 2) {
-                                if (k >= int(init0.str.size()))
+                                if (k >= int(init0.size()))
                                     break;
-                                init_data[j * 128 + (k / 2)] = init0.str[k] == Property::S1;
+                                init_data[j * 128 + (k / 2)] = init0.bit(k) == Property::S1;
                             }
                         }
                     }
@@ -1328,9 +1328,9 @@ struct FasmBackend
                         auto &init = ci->params.at(param);
                         has_init = true;
                         for (int k = 0; k < 256; k++) {
-                            if (k >= int(init.str.size()))
+                            if (k >= int(init.size()))
                                 break;
-                            init_data[k] = init.str[k] == Property::S1;
+                            init_data[k] = init.bit(k) == Property::S1;
                         }
                     }
                 }
@@ -219,11 +219,10 @@ void XilinxPacker::pack_dram()
             ++inverted_ports;
             if (ci->params.count(id_INIT)) {
                 Property &init = ci->params[id_INIT];
-                for (int j = 0; j < int(init.str.size()); j++) {
+                for (int j = 0; j < int(init.size()); j++) {
                     if (j & (1 << i))
-                        init.str[j] = init.str[j & ~(1 << i)];
+                        init.set_bit(j, init.bit(j & ~(1 << i)));
                 }
-                init.update_intval();
             }
         }
     }
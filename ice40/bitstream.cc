@@ -897,8 +897,8 @@ void write_asc(const Context *ctx, std::ostream &out)
                     std::vector<bool> bits(256);
                     Property init = get_or_default(cell.second->params, ctx->id(std::string("INIT_") + get_hexdigit(w)),
                                                    Property(0, 256));
-                    for (size_t i = 0; i < init.str.size(); i++) {
-                        bool val = (init.str.at(i) == Property::State::S1);
+                    for (size_t i = 0; i < init.size(); i++) {
+                        bool val = (init.bit(i) == Property::State::S1);
                         bits.at(i) = val;
                     }
                     for (int i = bits.size() - 4; i >= 0; i -= 4) {
@@ -629,6 +629,7 @@ DecalXY Arch::getGroupDecal(GroupId group) const
 
 bool Arch::get_delay_from_tmg_db(IdString tctype, IdString from, IdString to, DelayQuad &delay) const
 {
+    std::lock_guard<std::mutex> lock(celldelay_mutex);
     auto fnd_dk = celldelay_cache.find({tctype, from, to});
     if (fnd_dk != celldelay_cache.end()) {
         delay = fnd_dk->second.second;
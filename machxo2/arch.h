@@ -22,6 +22,7 @@
 #define MACHXO2_ARCH_H
 
 #include <cstdint>
+#include <mutex>
 #include <set>
 
 #include "base_arch.h"
@@ -1050,6 +1051,8 @@ struct Arch : BaseArch<ArchRanges>
     dict<WireId, std::pair<int, int>> wire_loc_overrides;
     void setup_wire_locations();
 
+    // Cell delays are also looked up from the worker threads of writeSDF
+    mutable std::mutex celldelay_mutex;
     mutable dict<DelayKey, std::pair<bool, DelayQuad>> celldelay_cache;
 
     // Global clock routing
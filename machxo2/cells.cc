@@ -124,7 +124,7 @@ static unsigned get_dram_init(const Context *ctx, const CellInfo *ram, int bit)
 {
     auto init_prop = get_or_default(ram->params, id_INITVAL, Property(0, 64));
     NPNR_ASSERT(!init_prop.is_string);
-    const std::string &idata = init_prop.str;
+    const std::string idata = init_prop.to_bit_string();
     NPNR_ASSERT(idata.length() == 64);
     unsigned value = 0;
     for (int i = 0; i < 16; i++) {
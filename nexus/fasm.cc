@@ -608,7 +608,7 @@ struct NexusFasmWriter
                     value = stringf("320'h%s", value.c_str());
                 } else {
                     // True Verilog bitvector
-                    value = stringf("320'b%s", prop.str.c_str());
+                    value = stringf("320'b%s", prop.to_bit_string().c_str());
                 }
                 write_bit(stringf("INITVAL_%02X[319:0] = %s", i, value.c_str()));
             }
@@ -919,7 +919,7 @@ struct NexusFasmWriter
                 value = stringf("5120'h%s", value.c_str());
             } else {
                 // True Verilog bitvector
-                value = stringf("5120'b%s", prop.str.c_str());
+                value = stringf("5120'b%s", prop.to_bit_string().c_str());
             }
             write_bit(stringf("INITVAL_%02X[5119:0] = %s", i, value.c_str()));
         }
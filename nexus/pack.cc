@@ -53,7 +53,7 @@ Property Arch::parse_lattice_param(const Property &val, IdString prop, int width
                 char c = s.at(i);
                 if (c != '0' && c != '1' && c != 'x')
                     log_error("Invalid binary digit '%c' in property %s.%s\n", c, ci, nameOf(prop));
-                temp.str.push_back(c);
+                temp.push_back(Property::State(c));
             }
         } else if (boost::starts_with(s, "0x")) {
             for (int i = int(s.length()) - 1; i >= 2; i--) {
@@ -68,7 +68,7 @@ Property Arch::parse_lattice_param(const Property &val, IdString prop, int width
                 else
                     log_error("Invalid hex digit '%c' in property %s.%s\n", c, ci, nameOf(prop));
                 for (int j = 0; j < 4; j++)
-                    temp.str.push_back(((nibble >> j) & 0x1) ? Property::S1 : Property::S0);
+                    temp.push_back(((nibble >> j) & 0x1) ? Property::S1 : Property::S0);
             }
         } else {
             int64_t ival = 0;
@@ -83,17 +83,16 @@ Property Arch::parse_lattice_param(const Property &val, IdString prop, int width
             temp = Property(ival);
         }
         if (int(temp.size()) > width) {
-            for (auto b : temp.str.substr(width)) {
-                if (b == Property::S1)
+            for (int i = width; i < int(temp.size()); i++) {
+                if (temp.bit(i) == Property::S1)
                     log_error("Found value for property %s.%s with width greater than %d\n", ci, nameOf(prop), width);
             }
         }
-        temp.update_intval();
         return temp.extract(0, width);
     } else {
-        if (int(val.str.size()) > width) {
-            for (auto b : val.str.substr(width)) {
-                if (b == Property::S1)
+        if (int(val.size()) > width) {
+            for (int i = width; i < int(val.size()); i++) {
+                if (val.bit(i) == Property::S1)
                     log_error("Found bitvector value for property %s.%s with width greater than %d - perhaps a string "
                               "was "
                               "converted to bits?\n",
@@ -1168,7 +1167,8 @@ struct NexusPacker
                 std::string name = stringf("INITVAL_%02X", i);
                 if (!ci->params.count(ctx->id(name)))
                     continue;
-                if (ci->params.at(ctx->id(name)).str.find_last_not_of("0x") == std::string::npos)
+                auto &init = ci->params.at(ctx->id(name));
+                if ((init.is_string ? init.str : init.to_bit_string()).find_last_not_of("0x") == std::string::npos)
                     continue;
                 log_error("LRAM initialisation is currently unsupported in ECC mode (to disable ECC, set ECC_BYTE_SEL "
                           "to BYTE_EN).\n");
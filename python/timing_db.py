@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+# Reader for the binary timing database written by nextpnr --timing-db; see common/kernel/timing_db.cc for the format.
+#
+# As a module:
+#   db = TimingDatabase("design.tdb")
+#   for domain_pair, setup, hold, crit in db.slacks("cell_name", "port_name"): ...
+#
+# From the command line:
+#   timing_db.py design.tdb                       summary and worst ports
+#   timing_db.py design.tdb cell_name port_name   times and slacks of one port
+
+import math
+import struct
+import sys
+from array import array
+
+def _time(value):
+    # Arrival and required times that were never set are stored as NaN
+    return None if math.isnan(value) else value
+
+def _format_time(value):
+    return "unset" if value is None else "{:.3f} ns".format(value)
+
+class TimingDatabase:
+    def __init__(self, filename):
+        with open(filename, "rb") as f:
+            self._data = f.read()
+        self._pos = 0
+        magic = self._read(8)
+        if magic != b"NPNRTDB\0":
+            raise ValueError("{} is not a nextpnr timing database".format(filename))
+        self.version, = self._unpack("<I")
+        if self.version != 1:
+            raise ValueError("unsupported timing database version {}".format(self.version))
+
+        n = self._count()
+        self.strings = []
+        for i in range(n):
+            length, = self._unpack("<I")
+            self.strings.append(self._read(length).decode("utf-8"))
+
+        n = self._count()
+        self.domain_clock = self._column("i", n)
+        self.domain_edge = self._column("B", n)
+
+        n = self._count()
+        self.pair_launch = self._column("i", n)
+        self.pair_capture = self._column("i", n)
+        self.pair_period = self._column("f", n)
+        self.pair_setup_slack = self._column("f", n)
+        self.pair_hold_slack = self._column("f", n)
+
+        n = self._count()
+        self.port_cell = self._column("i", n)
+        self.port_name = self._column("i", n)
+        self.port_type = self._column("B", n)
+        self.port_setup_slack = self._column("f", n)
+        self.port_hold_slack = self._column("f", n)
+        self.port_criticality = self._column("f", n)
+        self.arrival_offset = self._column("i", n + 1)
+        self.required_offset = self._column("i", n + 1)
+        self.pairs_offset = self._column("i", n + 1)
+
+        n = self._count()
+        self.edge_from = self._column("i", n)
+        self.edge_to = self._column("i", n)
+        self.edge_routing = self._column("B", n)
+        self.edge_min = self._column("f", n)
+        self.edge_max = self._column("f", n)
+
+        n = self._count()
+        self.arrival_domain = self._column("i", n)
+        self.arrival_min = self._column("f", n)
+        self.arrival_max = self._column("f", n)
+
+        n = self._count()
+        self.required_domain = self._column("i", n)
+        self.required_min = self._column("f", n)
+        self.required_max = self._column("f", n)
+
+        n = self._count()
+        self.port_pair = self._column("i", n)
+        self.port_pair_setup_slack = self._column("f", n)
+        self.port_pair_hold_slack = self._column("f", n)
+        self.port_pair_criticality = self._column("f", n)
+
+        self._port_index = {}
+        for i in range(len(self.port_cell)):
+            self._port_index[(self.strings[self.port_cell[i]], self.strings[self.port_name[i]])] = i
+
+    def _read(self, size):
+        data = self._data[self._pos:self._pos + size]
+        if len(data) != size:
+            raise ValueError("truncated timing database")
+        self._pos += size
+        return data
+
+    def _unpack(self, fmt):
+        return struct.unpack(fmt, self._read(struct.calcsize(fmt)))
+
+    def _count(self):
+        return self._unpack("<I")[0]
+
+    def _column(self, typecode, count):
+        col = array(typecode)
+        col.frombytes(self._read(col.itemsize * count))
+        if sys.byteorder != "little":
+            col.byteswap()
+        return col
+
+    def port(self, cell, port):
+        """Index of a port, given its cell and port names"""
+        return self._port_index[(cell, port)]
+
+    def port_names(self, idx):
+        return (self.strings[self.port_cell[idx]], self.strings[self.port_name[idx]])
+
+    def domain_name(self, domain):
+        clock = self.strings[self.domain_clock[domain]]
+        if clock == "":
+            return "<async>"
+        return "{}{}".format("negedge " if self.domain_edge[domain] else "posedge ", clock)
+
+    def pair_name(self, pair):
+        return "{} -> {}".format(self.domain_name(self.pair_launch[pair]), self.domain_name(self.pair_capture[pair]))
+
+    def arrivals(self, cell, port):
+        """List of (domain, min arrival ns, max arrival ns) for a port; times that were never set are None"""
+        idx = self.port(cell, port)
+        return [(self.arrival_domain[i], _time(self.arrival_min[i]), _time(self.arrival_max[i]))
+                for i in range(self.arrival_offset[idx], self.arrival_offset[idx + 1])]
+
+    def required(self, cell, port):
+        """List of (domain, min required ns, max required ns) for a port; times that were never set are None"""
+        idx = self.port(cell, port)
+        return [(self.required_domain[i], _time(self.required_min[i]), _time(self.required_max[i]))
+                for i in range(self.required_offset[idx], self.required_offset[idx + 1])]
+
+    def slacks(self, cell, port):
+        """List of (domain pair, setup slack ns, hold slack ns, criticality) for a port"""
+        idx = self.port(cell, port)
+        return [(self.port_pair[i], self.port_pair_setup_slack[i], self.port_pair_hold_slack[i],
+                 self.port_pair_criticality[i])
+                for i in range(self.pairs_offset[idx], self.pairs_offset[idx + 1])]
+
+    def worst_slack(self, cell, port):
+        """(setup slack ns, hold slack ns, criticality) across all domain pairs of a port"""
+        idx = self.port(cell, port)
+        return (self.port_setup_slack[idx], self.port_hold_slack[idx], self.port_criticality[idx])
+
+    def fanin(self, cell, port):
+        """List of (from port index, routing, min delay ns, max delay ns) for the timing edges into a port"""
+        idx = self.port(cell, port)
+        return [(self.edge_from[i], bool(self.edge_routing[i]), self.edge_min[i], self.edge_max[i])
+                for i in range(len(self.edge_to)) if self.edge_to[i] == idx]
+
+def main(argv):
+    if len(argv) not in (2, 4):
+        print("usage: {} <timing db> [<cell> <port>]".format(argv[0]), file=sys.stderr)
+        return 1
+    db = TimingDatabase(argv[1])
+    if len(argv) == 2:
+        print("{} ports, {} edges, {} domains".format(len(db.port_cell), len(db.edge_from), len(db.domain_clock)))
+        for pair in range(len(db.pair_launch)):
+            print("{}: period {:.3f} ns, worst setup slack {:.3f} ns, worst hold slack {:.3f} ns".format(
+                db.pair_name(pair), db.pair_period[pair], db.pair_setup_slack[pair], db.pair_hold_slack[pair]))
+        worst = sorted(range(len(db.port_cell)), key=lambda i: db.port_setup_slack[i])[:10]
+        print("worst setup slack ports:")
+        for idx in worst:
+            if db.port_setup_slack[idx] == float("inf"):
+                break
+            print("    {}.{}: {:.3f} ns".format(*db.port_names(idx), db.port_setup_slack[idx]))
+        return 0
+    cell, port = argv[2], argv[3]
+    for domain, amin, amax in db.arrivals(cell, port):
+        print("arrival  {}: min {}, max {}".format(db.domain_name(domain), _format_time(amin), _format_time(amax)))
+    for domain, rmin, rmax in db.required(cell, port):
+        print("required {}: min {}, max {}".format(db.domain_name(domain), _format_time(rmin), _format_time(rmax)))
+    for pair, setup, hold, crit in db.slacks(cell, port):
+        print("slack    {}: setup {:.3f} ns, hold {:.3f} ns, criticality {:.3f}".format(
+            db.pair_name(pair), setup, hold, crit))
+    for src, routing, dmin, dmax in db.fanin(cell, port):
+        print("fanin    {}.{} ({}): min {:.3f} ns, max {:.3f} ns".format(
+            *db.port_names(src), "routing" if routing else "cell", dmin, dmax))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))